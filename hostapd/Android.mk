@@ -166,6 +166,12 @@ ifdef CONFIG_ELOOP_EPOLL
 L_CFLAGS += -DCONFIG_ELOOP_EPOLL
 endif
 
+ifdef CONFIG_ELOOP_THREADS
+L_CFLAGS += -DCONFIG_ELOOP_THREADS
+LIBS += -lpthread
+LIBS_c += -lpthread
+endif
+
 OBJS += src/utils/common.c
 OBJS += src/utils/wpa_debug.c
 OBJS += src/utils/wpabuf.c
@@ -382,6 +388,9 @@ OBJS += src/l2_packet/l2_packet_pcap.c
 endif
 else
 OBJS += src/l2_packet/l2_packet_linux.c
+ifdef CONFIG_L2_PACKET_RING
+L_CFLAGS += -DCONFIG_L2_PACKET_RING
+endif
 endif
 else
 OBJS += src/l2_packet/l2_packet_none.c
@@ -1159,6 +1168,12 @@ ifdef CONFIG_DEBUG_FILE
 L_CFLAGS += -DCONFIG_DEBUG_FILE
 endif
 
+ifdef CONFIG_DEBUG_RING
+ifndef CONFIG_NO_STDOUT_DEBUG
+L_CFLAGS += -DCONFIG_DEBUG_RING
+endif
+endif
+
 ifdef CONFIG_ANDROID_LOG
 L_CFLAGS += -DCONFIG_ANDROID_LOG
 endif
@@ -118,76 +118,174 @@ static int hostapd_config_read_vlan_file(struct hostapd_bss_config *bss,
 #endif /* CONFIG_NO_VLAN */
 
 
+struct maclist_op {
+	u8 addr[ETH_ALEN];
+	bool rem;
+	int vlan_id;
+	int old; /* index of an already configured entry or -1 */
+	unsigned int seq;
+};
+
+
+static int hostapd_maclist_op_comp(const void *a, const void *b)
+{
+	const struct maclist_op *aa = a;
+	const struct maclist_op *bb = b;
+	int res;
+
+	res = os_memcmp(aa->addr, bb->addr, ETH_ALEN);
+	if (res)
+		return res;
+	if (aa->seq < bb->seq)
+		return -1;
+	return aa->seq > bb->seq;
+}
+
+
+static struct maclist_op * hostapd_maclist_op_add(struct maclist_op **ops,
+						  size_t *num, size_t *size)
+{
+	struct maclist_op *op;
+
+	if (*num == *size) {
+		size_t new_size = *size ? *size * 2 : 64;
+
+		op = os_realloc_array(*ops, new_size, sizeof(**ops));
+		if (!op) {
+			wpa_printf(MSG_ERROR, "MAC list reallocation failed");
+			return NULL;
+		}
+		*ops = op;
+		*size = new_size;
+	}
+
+	op = &(*ops)[*num];
+	os_memset(op, 0, sizeof(*op));
+	op->old = -1;
+	op->seq = (*num)++;
+	return op;
+}
+
+
 static int hostapd_config_read_maclist(const char *fname,
 				       struct mac_acl_entry **acl, int *num)
 {
-	FILE *f;
-	char buf[128], *pos;
-	int line = 0;
-	u8 addr[ETH_ALEN];
-	int vlan_id;
+	char *data, *buf, *pos, *context;
+	size_t len, num_ops = 0, size_ops = 0, i, j, k;
+	struct maclist_op *ops = NULL, *op;
+	struct mac_acl_entry *newacl = NULL, *entry;
+	int line = 0, count = 0, ret = -1;
+	struct os_reltime start, end, diff;
 
-	f = fopen(fname, "r");
-	if (!f) {
+	os_get_reltime(&start);
+
+	data = os_readfile(fname, &len);
+	if (!data) {
 		wpa_printf(MSG_ERROR, "MAC list file '%s' not found.", fname);
 		return -1;
 	}
+	buf = os_realloc(data, len + 1);
+	if (!buf)
+		goto fail;
+	data = buf;
+	data[len] = '\0';
+
+	/*
+	 * Collect the already configured entries and all additions and
+	 * removals from the file into a single array in the order they appear
+	 * and resolve the removals with a single sort instead of scanning the
+	 * list separately for each -MAC line.
+	 */
+	for (i = 0; i < (size_t) *num; i++) {
+		op = hostapd_maclist_op_add(&ops, &num_ops, &size_ops);
+		if (!op)
+			goto fail;
+		os_memcpy(op->addr, (*acl)[i].addr, ETH_ALEN);
+		op->old = i;
+	}
 
-	while (fgets(buf, sizeof(buf), f)) {
-		int rem = 0;
-
+	context = data;
+	while ((buf = str_line(&context))) {
 		line++;
 
-		if (buf[0] == '#')
-			continue;
-		pos = buf;
-		while (*pos != '\0') {
-			if (*pos == '\n') {
-				*pos = '\0';
-				break;
-			}
-			pos++;
-		}
-		if (buf[0] == '\0')
+		if (buf[0] == '#' || buf[0] == '\0')
 			continue;
+
+		op = hostapd_maclist_op_add(&ops, &num_ops, &size_ops);
+		if (!op)
+			goto fail;
+
 		pos = buf;
 		if (buf[0] == '-') {
-			rem = 1;
+			op->rem = true;
 			pos++;
 		}
 
-		if (hwaddr_aton(pos, addr)) {
+		if (hwaddr_aton(pos, op->addr)) {
 			wpa_printf(MSG_ERROR, "Invalid MAC address '%s' at "
 				   "line %d in '%s'", pos, line, fname);
-			fclose(f);
-			return -1;
+			goto fail;
 		}
 
-		if (rem) {
-			hostapd_remove_acl_mac(acl, num, addr);
+		if (op->rem)
 			continue;
-		}
-		vlan_id = 0;
 		pos = buf;
 		while (*pos != '\0' && *pos != ' ' && *pos != '\t')
 			pos++;
 		while (*pos == ' ' || *pos == '\t')
 			pos++;
 		if (*pos != '\0')
-			vlan_id = atoi(pos);
+			op->vlan_id = atoi(pos);
+	}
 
-		if (hostapd_add_acl_maclist(acl, num, vlan_id, addr) < 0) {
-			fclose(f);
-			return -1;
-		}
+	if (num_ops == 0)
+		goto done;
+
+	qsort(ops, num_ops, sizeof(*ops), hostapd_maclist_op_comp);
+
+	newacl = os_calloc(num_ops, sizeof(*newacl));
+	if (!newacl) {
+		wpa_printf(MSG_ERROR, "MAC list allocation failed");
+		goto fail;
 	}
 
-	fclose(f);
+	for (i = 0; i < num_ops; i = j) {
+		/* Only entries added after the last removal of the address
+		 * remain in the list */
+		k = i;
+		for (j = i; j < num_ops &&
+			     ether_addr_equal(ops[j].addr, ops[i].addr); j++) {
+			if (ops[j].rem)
+				k = j + 1;
+		}
+
+		for (; k < j; k++) {
+			entry = &newacl[count++];
+			if (ops[k].old >= 0) {
+				*entry = (*acl)[ops[k].old];
+				continue;
+			}
+			os_memcpy(entry->addr, ops[k].addr, ETH_ALEN);
+			entry->vlan_id.untagged = ops[k].vlan_id;
+			entry->vlan_id.notempty = !!ops[k].vlan_id;
+		}
+	}
 
-	if (*acl)
-		qsort(*acl, *num, sizeof(**acl), hostapd_acl_comp);
+	os_free(*acl);
+	*acl = newacl;
+	*num = count;
 
-	return 0;
+done:
+	os_get_reltime(&end);
+	os_reltime_sub(&end, &start, &diff);
+	wpa_printf(MSG_DEBUG,
+		   "MAC list '%s': %d entries from %d lines loaded in %ld.%06ld s",
+		   fname, *num, line, (long) diff.sec, (long) diff.usec);
+	ret = 0;
+fail:
+	os_free(ops);
+	os_free(data);
+	return ret;
 }
 
 
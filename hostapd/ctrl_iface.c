@@ -65,6 +65,7 @@
 #include "ap/dpp_hostapd.h"
 #include "ap/dfs.h"
 #include "ap/nan_usd_ap.h"
+#include "ap/gas_serv.h"
 #include "wps/wps_defs.h"
 #include "wps/wps.h"
 #include "fst/fst_ctrl_iface.h"
@@ -1278,9 +1279,20 @@ static int hostapd_ctrl_iface_set(struct hostapd_data *hapd, char *cmd)
 		ret = hostapd_ctrl_iface_set_band(hapd, value);
 	} else {
 		ret = hostapd_set_iface(hapd->iconf, hapd->conf, cmd, value);
+#ifdef CONFIG_IEEE80211R_AP
+		/* rxkh_file may have modified the lists even on failure */
+		if (os_strcmp(cmd, "r0kh") == 0 ||
+		    os_strcmp(cmd, "r1kh") == 0 ||
+		    os_strcmp(cmd, "rxkh_file") == 0)
+			wpa_ft_rkh_list_changed(hapd->wpa_auth);
+#endif /* CONFIG_IEEE80211R_AP */
 		if (ret)
 			return ret;
 
+#if defined(CONFIG_INTERWORKING) || defined(CONFIG_DPP)
+		gas_serv_anqp_cache_flush(hapd);
+#endif /* CONFIG_INTERWORKING || CONFIG_DPP */
+
 		if (os_strcasecmp(cmd, "deny_mac_file") == 0) {
 			hostapd_disassoc_deny_mac(hapd);
 		} else if (os_strcasecmp(cmd, "accept_mac_file") == 0) {
@@ -1515,6 +1527,7 @@ static int hostapd_ctrl_iface_reload_rxkhs(struct hostapd_data *hapd)
 	hostapd_config_clear_rxkhs(conf);
 
 	err = hostapd_config_read_rxkh_file(conf, conf->rxkh_file);
+	wpa_ft_rkh_list_changed(hapd->wpa_auth);
 	if (err < 0) {
 		wpa_printf(MSG_ERROR, "Reloading RxKHs failed: %d",
 			   err);
@@ -3185,6 +3198,39 @@ static int hostapd_ctrl_iface_log_level(struct hostapd_data *hapd, char *cmd,
 }
 
 
+#ifdef CONFIG_DEBUG_RING
+static int hostapd_ctrl_iface_log_ring_level(char *cmd, char *buf,
+					     size_t buflen)
+{
+	int ret, level;
+
+	/* cmd: "LOG_RING_LEVEL [<level>|OFF]" */
+	while (*cmd == ' ')
+		cmd++;
+	if (*cmd == '\0') {
+		ret = os_snprintf(buf, buflen, "%s\n",
+				  wpa_debug_ring_level > MSG_ERROR ? "OFF" :
+				  debug_level_str(wpa_debug_ring_level));
+		if (os_snprintf_error(buflen, ret))
+			ret = 0;
+		return ret;
+	}
+
+	if (os_strcasecmp(cmd, "OFF") == 0) {
+		level = MSG_ERROR + 1;
+	} else {
+		level = str_to_debug_level(cmd);
+		if (level < 0)
+			return -1;
+	}
+	wpa_debug_ring_level = level;
+
+	os_memcpy(buf, "OK\n", 3);
+	return 3;
+}
+#endif /* CONFIG_DEBUG_RING */
+
+
 #ifdef NEED_AP_MLME
 
 static int hostapd_ctrl_iface_track_sta_list(struct hostapd_data *hapd,
@@ -4096,6 +4142,11 @@ static int hostapd_ctrl_iface_receive_process(struct hostapd_data *hapd,
 				reply_len += res;
 		}
 #endif /* CONFIG_NO_RADIUS */
+#if defined(CONFIG_INTERWORKING) || defined(CONFIG_DPP)
+		if (reply_len >= 0)
+			reply_len += gas_serv_get_mib(hapd, reply + reply_len,
+						      reply_size - reply_len);
+#endif /* CONFIG_INTERWORKING || CONFIG_DPP */
 	} else if (os_strncmp(buf, "MIB ", 4) == 0) {
 		reply_len = hostapd_ctrl_iface_mib(hapd, reply, reply_size,
 						   buf + 4);
@@ -4108,6 +4159,12 @@ static int hostapd_ctrl_iface_receive_process(struct hostapd_data *hapd,
 	} else if (os_strncmp(buf, "STA-NEXT ", 9) == 0) {
 		reply_len = hostapd_ctrl_iface_sta_next(hapd, buf + 9, reply,
 							reply_size);
+	} else if (os_strcmp(buf, "STA-DUMP") == 0) {
+		reply_len = hostapd_ctrl_iface_sta_dump(hapd, "", reply,
+							reply_size);
+	} else if (os_strncmp(buf, "STA-DUMP ", 9) == 0) {
+		reply_len = hostapd_ctrl_iface_sta_dump(hapd, buf + 9, reply,
+							reply_size);
 	} else if (os_strcmp(buf, "ATTACH") == 0) {
 		if (hostapd_ctrl_iface_attach(hapd, from, fromlen, NULL))
 			reply_len = -1;
@@ -4346,6 +4403,16 @@ static int hostapd_ctrl_iface_receive_process(struct hostapd_data *hapd,
 	} else if (os_strncmp(buf, "LOG_LEVEL", 9) == 0) {
 		reply_len = hostapd_ctrl_iface_log_level(
 			hapd, buf + 9, reply, reply_size);
+#ifdef CONFIG_DEBUG_RING
+	} else if (os_strcmp(buf, "LOG_RING") == 0) {
+		reply_len = wpa_debug_ring_dump(reply, reply_size, 0);
+	} else if (os_strncmp(buf, "LOG_RING ", 9) == 0) {
+		reply_len = wpa_debug_ring_dump(reply, reply_size,
+						atoi(buf + 9));
+	} else if (os_strncmp(buf, "LOG_RING_LEVEL", 14) == 0) {
+		reply_len = hostapd_ctrl_iface_log_ring_level(
+			buf + 14, reply, reply_size);
+#endif /* CONFIG_DEBUG_RING */
 #ifdef NEED_AP_MLME
 	} else if (os_strcmp(buf, "TRACK_STA_LIST") == 0) {
 		reply_len = hostapd_ctrl_iface_track_sta_list(
@@ -4667,7 +4734,7 @@ static void hostapd_ctrl_iface_receive(int sock, void *eloop_ctx,
 	struct sockaddr_storage from;
 	socklen_t fromlen = sizeof(from);
 	char *reply, *pos = buf;
-	const int reply_size = 4096;
+	int reply_size = 4096;
 	int reply_len;
 	int level = MSG_DEBUG;
 #ifdef CONFIG_CTRL_IFACE_UDP
@@ -4683,6 +4750,11 @@ static void hostapd_ctrl_iface_receive(int sock, void *eloop_ctx,
 	}
 	buf[res] = '\0';
 
+	if (os_strcmp(buf, "STA-DUMP") == 0 ||
+	    os_strncmp(buf, "STA-DUMP ", 9) == 0 ||
+	    os_strncmp(buf, "LOG_RING", 8) == 0)
+		reply_size = WPA_CTRL_BULK_REPLY_SIZE;
+
 	reply = os_malloc(reply_size);
 	if (reply == NULL) {
 		if (sendto(sock, "FAIL\n", 5, 0, (struct sockaddr *) &from,
@@ -5115,6 +5187,24 @@ static void hostapd_ctrl_iface_msg_cb(void *ctx, int level,
 }
 
 
+static int hostapd_ctrl_iface_msg_wanted(void *ctx, int level,
+					 enum wpa_msg_type type)
+{
+	struct hostapd_data *hapd = ctx;
+
+	if (!hapd)
+		return 0;
+	if (type != WPA_MSG_NO_GLOBAL &&
+	    ctrl_iface_monitor_wanted(&hapd->iface->interfaces->global_ctrl_dst,
+				      level))
+		return 1;
+	if (type != WPA_MSG_ONLY_GLOBAL &&
+	    ctrl_iface_monitor_wanted(&hapd->ctrl_dst, level))
+		return 1;
+	return 0;
+}
+
+
 int hostapd_ctrl_iface_init(struct hostapd_data *hapd)
 {
 #ifdef CONFIG_CTRL_IFACE_UDP
@@ -5202,6 +5292,7 @@ try_again:
 
 	hapd->msg_ctx = hapd;
 	wpa_msg_register_cb(hostapd_ctrl_iface_msg_cb);
+	wpa_msg_register_wanted_cb(hostapd_ctrl_iface_msg_wanted);
 
 	return 0;
 
@@ -5355,6 +5446,7 @@ fail:
 	}
 	hapd->msg_ctx = hapd;
 	wpa_msg_register_cb(hostapd_ctrl_iface_msg_cb);
+	wpa_msg_register_wanted_cb(hostapd_ctrl_iface_msg_wanted);
 
 	return 0;
 
@@ -6007,6 +6099,7 @@ try_again:
 	}
 
 	wpa_msg_register_cb(hostapd_ctrl_iface_msg_cb);
+	wpa_msg_register_wanted_cb(hostapd_ctrl_iface_msg_wanted);
 
 	return 0;
 
@@ -6111,6 +6204,7 @@ fail:
 				 interface, NULL);
 
 	wpa_msg_register_cb(hostapd_ctrl_iface_msg_cb);
+	wpa_msg_register_wanted_cb(hostapd_ctrl_iface_msg_wanted);
 
 	return 0;
 
@@ -6221,8 +6315,8 @@ static void hostapd_ctrl_iface_send_internal(int sock, struct dl_list *ctrl_dst,
 
 	idx = 0;
 	dl_list_for_each_safe(dst, next, ctrl_dst, struct wpa_ctrl_dst, list) {
-		if ((level >= dst->debug_level) &&
-		     hostapd_ctrl_check_event_enabled(dst, buf)) {
+		if (ctrl_iface_event_wanted(dst, level, buf, len) &&
+		    hostapd_ctrl_check_event_enabled(dst, buf)) {
 			sockaddr_print(MSG_DEBUG, "CTRL_IFACE monitor send",
 				       &dst->addr, dst->addrlen);
 			msg.msg_name = &dst->addr;
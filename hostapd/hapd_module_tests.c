@@ -10,9 +10,14 @@
 
 #include "utils/common.h"
 #include "utils/module_tests.h"
+#include "ap/wpa_auth.h"
 
 int hapd_module_tests(void)
 {
 	wpa_printf(MSG_INFO, "hostapd module tests");
+#ifdef CONFIG_IEEE80211R_AP
+	if (wpa_ft_rkh_module_tests() < 0)
+		return -1;
+#endif /* CONFIG_IEEE80211R_AP */
 	return 0;
 }
@@ -321,44 +321,56 @@ int hostapd_mac_comp(const void *a, const void *b)
 static int hostapd_config_read_wpa_psk(const char *fname,
 				       struct hostapd_ssid *ssid)
 {
-	FILE *f;
-	char buf[128], *pos;
+	char *data, *buf, *pos, *lines;
+	size_t data_len;
 	const char *keyid;
 	char *context;
 	char *context2;
 	char *token;
 	char *name;
 	char *value;
-	int line = 0, ret = 0, len, ok;
+	int line = 0, ret = 0, len, ok, entries = 0;
 	u8 addr[ETH_ALEN];
 	struct hostapd_wpa_psk *psk;
+	struct os_reltime start, end, diff;
 
 	if (!fname)
 		return 0;
 
-	f = fopen(fname, "r");
-	if (!f) {
+	os_get_reltime(&start);
+
+	data = os_readfile(fname, &data_len);
+	if (!data) {
 		wpa_printf(MSG_ERROR, "WPA PSK file '%s' not found.", fname);
 		return -1;
 	}
+	/* Copy into a NUL terminated buffer instead of using os_realloc() so
+	 * that no uncleared copy of the keys is left behind in the heap */
+	buf = os_malloc(data_len + 1);
+	if (buf)
+		os_memcpy(buf, data, data_len);
+	bin_clear_free(data, data_len);
+	if (!buf)
+		return -1;
+	data = buf;
+	data[data_len] = '\0';
 
-	while (fgets(buf, sizeof(buf), f)) {
+	if (os_strlen(data) != data_len) {
+		wpa_printf(MSG_ERROR,
+			   "WPA PSK file '%s' contains a NUL character",
+			   fname);
+		bin_clear_free(data, data_len + 1);
+		return -1;
+	}
+
+	lines = data;
+	while ((buf = str_line(&lines))) {
 		int vlan_id = 0;
 		int wps = 0;
 
 		line++;
 
-		if (buf[0] == '#')
-			continue;
-		pos = buf;
-		while (*pos != '\0') {
-			if (*pos == '\n') {
-				*pos = '\0';
-				break;
-			}
-			pos++;
-		}
-		if (buf[0] == '\0')
+		if (buf[0] == '#' || buf[0] == '\0')
 			continue;
 
 		context = NULL;
@@ -456,9 +468,16 @@ static int hostapd_config_read_wpa_psk(const char *fname,
 
 		psk->next = ssid->wpa_psk;
 		ssid->wpa_psk = psk;
+		entries++;
 	}
 
-	fclose(f);
+	bin_clear_free(data, data_len + 1);
+
+	os_get_reltime(&end);
+	os_reltime_sub(&end, &start, &diff);
+	wpa_printf(MSG_DEBUG,
+		   "WPA PSK file '%s': %d entries from %d lines loaded in %ld.%06ld s",
+		   fname, entries, line, (long) diff.sec, (long) diff.usec);
 
 	return ret;
 }
@@ -1781,14 +1800,14 @@ int hostapd_add_acl_maclist(struct mac_acl_entry **acl, int *num,
 void hostapd_remove_acl_mac(struct mac_acl_entry **acl, int *num,
 			    const u8 *addr)
 {
-	int i = 0;
+	int i, j = 0;
 
-	while (i < *num) {
-		if (ether_addr_equal((*acl)[i].addr, addr)) {
-			os_remove_in_array(*acl, *num, sizeof(**acl), i);
-			(*num)--;
-		} else {
-			i++;
-		}
+	for (i = 0; i < *num; i++) {
+		if (ether_addr_equal((*acl)[i].addr, addr))
+			continue;
+		if (i != j)
+			(*acl)[j] = (*acl)[i];
+		j++;
 	}
+	*num = j;
 }
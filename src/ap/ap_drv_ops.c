@@ -897,6 +897,45 @@ int hostapd_drv_send_mlme(struct hostapd_data *hapd,
 }
 
 
+int hostapd_drv_hapd_send_eapol_vector(struct hostapd_data *hapd,
+				       const u8 *addr, size_t num_elem,
+				       const u8 *elem[],
+				       const size_t *elem_len, int encrypt,
+				       u32 flags, int link_id)
+{
+	u8 *buf, *pos;
+	size_t i, len = 0;
+	int ret;
+
+	if (!hapd->driver)
+		return 0;
+	if (hapd->driver->hapd_send_eapol_vector)
+		return hapd->driver->hapd_send_eapol_vector(
+			hapd->drv_priv, addr, num_elem, elem, elem_len,
+			encrypt, hapd->own_addr, flags, link_id);
+	if (num_elem == 1)
+		return hostapd_drv_hapd_send_eapol(hapd, addr, elem[0],
+						   elem_len[0], encrypt,
+						   flags, link_id);
+
+	/* Driver needs a contiguous frame */
+	for (i = 0; i < num_elem; i++)
+		len += elem_len[i];
+	buf = os_malloc(len);
+	if (!buf)
+		return -1;
+	pos = buf;
+	for (i = 0; i < num_elem; i++) {
+		os_memcpy(pos, elem[i], elem_len[i]);
+		pos += elem_len[i];
+	}
+	ret = hostapd_drv_hapd_send_eapol(hapd, addr, buf, len, encrypt,
+					  flags, link_id);
+	os_free(buf);
+	return ret;
+}
+
+
 int hostapd_drv_sta_deauth(struct hostapd_data *hapd,
 			   const u8 *addr, int reason)
 {
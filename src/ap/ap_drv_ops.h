@@ -106,6 +106,11 @@ int hostapd_drv_send_mlme(struct hostapd_data *hapd,
 			  const void *msg, size_t len, int noack,
 			  const u16 *csa_offs, size_t csa_offs_len,
 			  int no_encrypt);
+int hostapd_drv_hapd_send_eapol_vector(struct hostapd_data *hapd,
+				       const u8 *addr, size_t num_elem,
+				       const u8 *elem[],
+				       const size_t *elem_len, int encrypt,
+				       u32 flags, int link_id);
 int hostapd_drv_sta_deauth(struct hostapd_data *hapd,
 			   const u8 *addr, int reason);
 int hostapd_drv_sta_disassoc(struct hostapd_data *hapd,
@@ -122,6 +127,19 @@ int hostapd_drv_send_action_forced_addr3(struct hostapd_data *hapd,
 					 unsigned int wait, const u8 *dst,
 					 const u8 *a3,
 					 const u8 *data, size_t len);
+
+/*
+ * Forget the Beacon template last pushed to the driver so that the next
+ * ieee802_11_set_beacon() call updates the driver unconditionally. This needs
+ * to be done whenever the driver may have changed or dropped the template
+ * without going through set_ap().
+ */
+static inline void hostapd_beacon_tmpl_flush(struct hostapd_data *hapd)
+{
+	wpabuf_clear_free(hapd->beacon_tmpl);
+	hapd->beacon_tmpl = NULL;
+}
+
 static inline void
 hostapd_drv_send_action_cancel_wait(struct hostapd_data *hapd)
 {
@@ -322,6 +340,7 @@ static inline int hostapd_drv_switch_channel(struct hostapd_data *hapd,
 	    hapd->drv_priv == NULL)
 		return -1;
 
+	hostapd_beacon_tmpl_flush(hapd);
 	return hapd->driver->switch_channel(hapd->drv_priv, settings);
 }
 
@@ -332,6 +351,7 @@ static inline int hostapd_drv_switch_color(struct hostapd_data *hapd,
 	if (!hapd->driver || !hapd->driver->switch_color || !hapd->drv_priv)
 		return -1;
 
+	hostapd_beacon_tmpl_flush(hapd);
 	return hapd->driver->switch_color(hapd->drv_priv, settings);
 }
 #endif /* CONFIG_IEEE80211AX */
@@ -403,6 +423,7 @@ static inline int hostapd_drv_stop_ap(struct hostapd_data *hapd)
 
 	if (!hapd->driver || !hapd->driver->stop_ap || !hapd->drv_priv)
 		return 0;
+	hostapd_beacon_tmpl_flush(hapd);
 #ifdef CONFIG_IEEE80211BE
 	if (hapd->conf->mld_ap)
 		link_id = hapd->mld_link_id;
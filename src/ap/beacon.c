@@ -2662,6 +2662,136 @@ void ieee802_11_free_ap_params(struct wpa_driver_ap_params *params)
 }
 
 
+static int beacon_tmpl_put(struct wpabuf **buf, const void *data, size_t len)
+{
+	if (wpabuf_resize(buf, 4 + len))
+		return -1;
+	wpabuf_put_le32(*buf, len);
+	if (data)
+		wpabuf_put_data(*buf, data, len);
+	return 0;
+}
+
+
+static int beacon_tmpl_put_buf(struct wpabuf **buf, const struct wpabuf *data)
+{
+	if (!data)
+		return beacon_tmpl_put(buf, NULL, 0);
+	return beacon_tmpl_put(buf, wpabuf_head(data), wpabuf_len(data));
+}
+
+
+static int beacon_tmpl_put_offsets(struct wpabuf **buf, const u8 *base,
+				   u8 **offset, size_t count)
+{
+	size_t i;
+
+	if (!offset)
+		count = 0;
+	if (wpabuf_resize(buf, 4 + count * 4))
+		return -1;
+	wpabuf_put_le32(*buf, count);
+	for (i = 0; i < count; i++)
+		wpabuf_put_le32(*buf, offset[i] ? offset[i] - base : 0);
+	return 0;
+}
+
+
+/*
+ * Serialize everything in the AP parameters that the driver could act on. The
+ * flat structure is copied with all pointers cleared and the pointed-to data
+ * is appended, so two serializations compare equal only if the driver would
+ * have received identical parameters.
+ */
+static struct wpabuf *
+ieee802_11_serialize_ap_params(const struct wpa_driver_ap_params *params)
+{
+	struct wpa_driver_ap_params flat;
+	const struct mbssid_data *mbssid = &params->mbssid;
+	struct wpabuf *buf;
+	int ret;
+
+	os_memcpy(&flat, params, sizeof(flat));
+	flat.head = NULL;
+	flat.tail = NULL;
+	flat.basic_rates = NULL;
+	flat.proberesp = NULL;
+	flat.ssid = NULL;
+	flat.beacon_ies = NULL;
+	flat.proberesp_ies = NULL;
+	flat.assocresp_ies = NULL;
+	flat.hessid = NULL;
+	flat.freq = NULL;
+	flat.lci = NULL;
+	flat.civic = NULL;
+	flat.fd_frame_tmpl = NULL;
+	flat.mbssid.mbssid_tx_iface = NULL;
+	flat.mbssid.mbssid_elem = NULL;
+	flat.mbssid.mbssid_elem_offset = NULL;
+	flat.mbssid.rnr_elem = NULL;
+	flat.mbssid.rnr_elem_offset = NULL;
+	flat.ubpr.unsol_bcast_probe_resp_tmpl = NULL;
+	flat.allowed_freqs = NULL;
+	flat.sae_password = NULL;
+
+	buf = wpabuf_alloc(sizeof(flat) + params->head_len + params->tail_len +
+			   params->proberesp_len + mbssid->mbssid_elem_len +
+			   mbssid->rnr_elem_len + 256);
+	if (!buf)
+		return NULL;
+	wpabuf_put_data(buf, &flat, sizeof(flat));
+
+	ret = beacon_tmpl_put(&buf, params->head, params->head_len) ||
+		beacon_tmpl_put(&buf, params->tail, params->tail_len) ||
+		beacon_tmpl_put(&buf, params->basic_rates,
+				params->basic_rates ?
+				(int_array_len(params->basic_rates) + 1) *
+				sizeof(int) : 0) ||
+		beacon_tmpl_put(&buf, params->proberesp,
+				params->proberesp_len) ||
+		beacon_tmpl_put(&buf, params->ssid, params->ssid_len) ||
+		beacon_tmpl_put_buf(&buf, params->beacon_ies) ||
+		beacon_tmpl_put_buf(&buf, params->proberesp_ies) ||
+		beacon_tmpl_put_buf(&buf, params->assocresp_ies) ||
+		beacon_tmpl_put(&buf, params->hessid,
+				params->hessid ? ETH_ALEN : 0) ||
+		beacon_tmpl_put(&buf, params->freq,
+				params->freq ? sizeof(*params->freq) : 0) ||
+		beacon_tmpl_put_buf(&buf, params->lci) ||
+		beacon_tmpl_put_buf(&buf, params->civic) ||
+		beacon_tmpl_put(&buf, params->fd_frame_tmpl,
+				params->fd_frame_tmpl_len) ||
+		beacon_tmpl_put(&buf, mbssid->mbssid_tx_iface,
+				mbssid->mbssid_tx_iface ?
+				os_strlen(mbssid->mbssid_tx_iface) : 0) ||
+		beacon_tmpl_put(&buf, mbssid->mbssid_elem,
+				mbssid->mbssid_elem_len) ||
+		beacon_tmpl_put_offsets(&buf, mbssid->mbssid_elem,
+					mbssid->mbssid_elem_offset,
+					mbssid->mbssid_elem_count) ||
+		beacon_tmpl_put(&buf, mbssid->rnr_elem,
+				mbssid->rnr_elem_len) ||
+		beacon_tmpl_put_offsets(&buf, mbssid->rnr_elem,
+					mbssid->rnr_elem_offset,
+					mbssid->rnr_elem_count) ||
+		beacon_tmpl_put(&buf, params->ubpr.unsol_bcast_probe_resp_tmpl,
+				params->ubpr.unsol_bcast_probe_resp_tmpl_len) ||
+		beacon_tmpl_put(&buf, params->allowed_freqs,
+				params->allowed_freqs ?
+				(int_array_len(params->allowed_freqs) + 1) *
+				sizeof(int) : 0) ||
+		beacon_tmpl_put(&buf, params->sae_password,
+				params->sae_password ?
+				os_strlen(params->sae_password) : 0);
+	if (ret) {
+		wpabuf_clear_free(buf);
+		return NULL;
+	}
+
+	return buf;
+}
+
+
 static int __ieee802_11_set_beacon(struct hostapd_data *hapd)
 {
 	struct wpa_driver_ap_params params;
@@ -2669,7 +2799,7 @@ static int __ieee802_11_set_beacon(struct hostapd_data *hapd)
 	struct hostapd_iface *iface = hapd->iface;
 	struct hostapd_config *iconf = iface->conf;
 	struct hostapd_hw_modes *cmode = iface->current_mode;
-	struct wpabuf *beacon, *proberesp, *assocresp;
+	struct wpabuf *beacon, *proberesp, *assocresp, *tmpl;
 	bool twt_he_responder = false;
 	int res, ret = -1, i;
 	struct hostapd_hw_modes *mode;
@@ -2769,7 +2899,22 @@ static int __ieee802_11_set_beacon(struct hostapd_data *hapd)
 						 true, &params.allowed_freqs);
 	}
 
-	res = hostapd_drv_set_ap(hapd, &params);
+	tmpl = ieee802_11_serialize_ap_params(&params);
+	if (tmpl && hapd->beacon_tmpl && !params.reenable &&
+	    wpabuf_cmp(tmpl, hapd->beacon_tmpl) == 0) {
+		wpa_printf(MSG_DEBUG,
+			   "%s: Beacon parameters unchanged - skip driver update",
+			   hapd->conf->iface);
+		res = 0;
+	} else {
+		res = hostapd_drv_set_ap(hapd, &params);
+		hostapd_beacon_tmpl_flush(hapd);
+		if (res == 0) {
+			hapd->beacon_tmpl = tmpl;
+			tmpl = NULL;
+		}
+	}
+	wpabuf_clear_free(tmpl);
 	hostapd_free_ap_extra_ies(hapd, beacon, proberesp, assocresp);
 	if (res)
 		wpa_printf(MSG_ERROR, "Failed to set beacon parameters");
@@ -572,6 +572,68 @@ int hostapd_ctrl_iface_sta_next(struct hostapd_data *hapd, const char *txtaddr,
 }
 
 
+/* STA-DUMP [<addr>]
+ * Print as many station entries as fit into the reply, starting from the
+ * first station or from the station following the specified address. The
+ * last line is "####" if the dump reached the end of the station list.
+ * Otherwise, the dump can be continued with the address of the last included
+ * station. */
+int hostapd_ctrl_iface_sta_dump(struct hostapd_data *hapd, const char *txtaddr,
+				char *buf, size_t buflen)
+{
+	u8 addr[ETH_ALEN];
+	struct sta_info *sta;
+	char *tmp;
+	int len, ret = 0;
+	size_t tmp_len = 4096;
+
+	if (*txtaddr) {
+		if (hwaddr_aton(txtaddr, addr) ||
+		    (sta = ap_get_sta(hapd, addr)) == NULL) {
+			ret = os_snprintf(buf, buflen, "FAIL\n");
+			if (os_snprintf_error(buflen, ret))
+				return 0;
+			return ret;
+		}
+		sta = sta->next;
+	} else {
+		sta = hapd->sta_list;
+	}
+
+	/* hostapd_ctrl_iface_sta_mib() truncates the output on overflow, so
+	 * print each entry into a temporary buffer of the size used for a
+	 * single STA reply and copy only complete entries into the dump. */
+	tmp = os_malloc(tmp_len);
+	if (!tmp)
+		return -1;
+
+	for (; sta; sta = sta->next) {
+		len = hostapd_ctrl_iface_sta_mib(hapd, sta, tmp, tmp_len);
+		if ((size_t) len >= buflen - ret)
+			break;
+		os_memcpy(buf + ret, tmp, len);
+		ret += len;
+	}
+	os_free(tmp);
+
+	if (sta && ret == 0) {
+		/* Not even a single entry fits into the reply buffer, so the
+		 * client could not make any progress */
+		ret = os_snprintf(buf, buflen, "FAIL\n");
+		if (os_snprintf_error(buflen, ret))
+			return 0;
+		return ret;
+	}
+
+	if (!sta && buflen - ret > 5) {
+		os_memcpy(buf + ret, "####\n", 5);
+		ret += 5;
+	}
+
+	return ret;
+}
+
+
 #ifdef CONFIG_P2P_MANAGER
 static int p2p_manager_disconnect(struct hostapd_data *hapd, u16 stype,
 				  u8 minor_reason_code, const u8 *addr)
@@ -1564,8 +1626,9 @@ int hostapd_ctrl_iface_acl_del_mac(struct mac_acl_entry **acl, int *num,
 void hostapd_ctrl_iface_acl_clear_list(struct mac_acl_entry **acl,
 				       int *num)
 {
-	while (*num)
-		hostapd_remove_acl_mac(acl, num, (*acl)[0].addr);
+	os_free(*acl);
+	*acl = NULL;
+	*num = 0;
 }
 
 
@@ -1596,7 +1659,8 @@ int hostapd_ctrl_iface_acl_add_mac(struct mac_acl_entry **acl, int *num,
 {
 	u8 addr[ETH_ALEN];
 	struct vlan_description vlan_id;
-	int ret = 0, vlanid = 0;
+	struct mac_acl_entry entry;
+	int ret = 0, vlanid = 0, i;
 	const char *pos;
 
 	if (hwaddr_aton(cmd, addr))
@@ -1608,8 +1672,17 @@ int hostapd_ctrl_iface_acl_add_mac(struct mac_acl_entry **acl, int *num,
 
 	if (!hostapd_maclist_found(*acl, *num, addr, &vlan_id)) {
 		ret = hostapd_add_acl_maclist(acl, num, vlanid, addr);
-		if (ret != -1 && *acl)
-			qsort(*acl, *num, sizeof(**acl), hostapd_acl_comp);
+		if (ret < 0)
+			return -1;
+
+		/* Move the new entry into place to keep the list sorted */
+		i = *num - 1;
+		entry = (*acl)[i];
+		while (i > 0 && hostapd_acl_comp(&(*acl)[i - 1], &entry) > 0) {
+			(*acl)[i] = (*acl)[i - 1];
+			i--;
+		}
+		(*acl)[i] = entry;
 	}
 
 	return ret < 0 ? -1 : 0;
@@ -2108,7 +2108,8 @@ static void hostapd_dpp_rx_peer_disc_req(struct hostapd_data *hapd,
 		return;
 	}
 
-	res = dpp_peer_intro(&intro, hapd->conf->dpp_connector,
+	res = dpp_peer_intro(hapd->iface->interfaces->dpp, &intro,
+			     hapd->conf->dpp_connector,
 			     wpabuf_head(hapd->conf->dpp_netaccesskey),
 			     wpabuf_len(hapd->conf->dpp_netaccesskey),
 			     wpabuf_head(hapd->conf->dpp_csign),
@@ -2904,7 +2905,8 @@ hostapd_dpp_rx_priv_peer_intro_update(struct hostapd_data *hapd, const u8 *src,
 		goto done;
 	}
 
-	res = dpp_peer_intro(&intro, hapd->conf->dpp_connector,
+	res = dpp_peer_intro(hapd->iface->interfaces->dpp, &intro,
+			     hapd->conf->dpp_connector,
 			     wpabuf_head(hapd->conf->dpp_netaccesskey),
 			     wpabuf_len(hapd->conf->dpp_netaccesskey),
 			     wpabuf_head(hapd->conf->dpp_csign),
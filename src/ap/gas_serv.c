@@ -717,6 +717,116 @@ static void anqp_add_mbo_cell_data_conn_pref(struct hostapd_data *hapd,
 #endif /* CONFIG_MBO */
 
 
+enum anqp_cache_id {
+	ANQP_CACHE_CAPABILITY_LIST,
+	ANQP_CACHE_VENUE_NAME,
+	ANQP_CACHE_NETWORK_AUTH_TYPE,
+	ANQP_CACHE_ROAMING_CONSORTIUM,
+	ANQP_CACHE_IP_ADDR_TYPE_AVAILABILITY,
+	ANQP_CACHE_NAI_REALM,
+	ANQP_CACHE_3GPP_CELLULAR_NETWORK,
+	ANQP_CACHE_DOMAIN_NAME,
+	ANQP_CACHE_FILS_REALM_INFO,
+	ANQP_CACHE_VENUE_URL,
+	ANQP_CACHE_HS_CAPABILITY_LIST,
+	ANQP_CACHE_OPERATOR_FRIENDLY_NAME,
+	ANQP_CACHE_WAN_METRICS,
+	ANQP_CACHE_CONNECTION_CAPABILITY,
+	ANQP_CACHE_OPERATING_CLASS,
+	ANQP_CACHE_MBO_CELL_DATA_CONN_PREF,
+	NUM_ANQP_CACHE
+};
+
+struct gas_serv_anqp_cache {
+	/* Serialized ANQP-element(s) or %NULL if not yet built */
+	struct wpabuf *elem[NUM_ANQP_CACHE];
+	unsigned int hits;
+	unsigned int misses;
+	unsigned long long bytes;
+};
+
+
+static void anqp_add_nai_realm_list(struct hostapd_data *hapd,
+				    struct wpabuf *buf)
+{
+	anqp_add_nai_realm(hapd, buf, NULL, 0, 1, 0);
+}
+
+
+/*
+ * The ANQP-elements that depend only on the BSS configuration are identical
+ * for every query, so serialize them once and copy the result into following
+ * responses until the configuration changes.
+ */
+static void anqp_add_cached(struct hostapd_data *hapd, struct wpabuf *buf,
+			    enum anqp_cache_id id,
+			    void (*build)(struct hostapd_data *hapd,
+					  struct wpabuf *buf))
+{
+	struct gas_serv_anqp_cache *cache = hapd->anqp_cache;
+	struct wpabuf *elem;
+	size_t start;
+
+	if (!cache) {
+		build(hapd, buf);
+		return;
+	}
+
+	elem = cache->elem[id];
+	if (elem) {
+		if (wpabuf_tailroom(buf) < wpabuf_len(elem)) {
+			wpa_printf(MSG_DEBUG,
+				   "ANQP: No room for cached element %d", id);
+			return;
+		}
+		wpabuf_put_buf(buf, elem);
+		cache->hits++;
+		cache->bytes += wpabuf_len(elem);
+		return;
+	}
+
+	start = wpabuf_len(buf);
+	build(hapd, buf);
+	cache->misses++;
+	cache->elem[id] = wpabuf_alloc_copy(wpabuf_head_u8(buf) + start,
+					    wpabuf_len(buf) - start);
+}
+
+
+void gas_serv_anqp_cache_flush(struct hostapd_data *hapd)
+{
+	struct gas_serv_anqp_cache *cache = hapd->anqp_cache;
+	unsigned int i;
+
+	if (!cache)
+		return;
+
+	for (i = 0; i < NUM_ANQP_CACHE; i++) {
+		wpabuf_free(cache->elem[i]);
+		cache->elem[i] = NULL;
+	}
+}
+
+
+int gas_serv_get_mib(struct hostapd_data *hapd, char *buf, size_t buflen)
+{
+	struct gas_serv_anqp_cache *cache = hapd->anqp_cache;
+	int ret;
+
+	if (!cache)
+		return 0;
+
+	ret = os_snprintf(buf, buflen,
+			  "hostapdANQPCacheHits=%u\n"
+			  "hostapdANQPCacheMisses=%u\n"
+			  "hostapdANQPCacheBytesServed=%llu\n",
+			  cache->hits, cache->misses, cache->bytes);
+	if (os_snprintf_error(buflen, ret))
+		return 0;
+	return ret;
+}
+
+
 static size_t anqp_get_required_len(struct hostapd_data *hapd,
 				    const u16 *infoid,
 				    unsigned int num_infoid)
@@ -760,23 +870,33 @@ gas_serv_build_gas_resp_payload(struct hostapd_data *hapd,
 		return NULL;
 
 	if (request & ANQP_REQ_CAPABILITY_LIST)
-		anqp_add_capab_list(hapd, buf);
+		anqp_add_cached(hapd, buf, ANQP_CACHE_CAPABILITY_LIST,
+				anqp_add_capab_list);
 	if (request & ANQP_REQ_VENUE_NAME)
-		anqp_add_venue_name(hapd, buf);
+		anqp_add_cached(hapd, buf, ANQP_CACHE_VENUE_NAME,
+				anqp_add_venue_name);
 	if (request & ANQP_REQ_EMERGENCY_CALL_NUMBER)
 		anqp_add_elem(hapd, buf, ANQP_EMERGENCY_CALL_NUMBER);
 	if (request & ANQP_REQ_NETWORK_AUTH_TYPE)
-		anqp_add_network_auth_type(hapd, buf);
+		anqp_add_cached(hapd, buf, ANQP_CACHE_NETWORK_AUTH_TYPE,
+				anqp_add_network_auth_type);
 	if (request & ANQP_REQ_ROAMING_CONSORTIUM)
-		anqp_add_roaming_consortium(hapd, buf);
+		anqp_add_cached(hapd, buf, ANQP_CACHE_ROAMING_CONSORTIUM,
+				anqp_add_roaming_consortium);
 	if (request & ANQP_REQ_IP_ADDR_TYPE_AVAILABILITY)
-		anqp_add_ip_addr_type_availability(hapd, buf);
-	if (request & (ANQP_REQ_NAI_REALM | ANQP_REQ_NAI_HOME_REALM))
+		anqp_add_cached(hapd, buf, ANQP_CACHE_IP_ADDR_TYPE_AVAILABILITY,
+				anqp_add_ip_addr_type_availability);
+	if ((request & ANQP_REQ_NAI_REALM) &&
+	    !(request & ANQP_REQ_NAI_HOME_REALM))
+		anqp_add_cached(hapd, buf, ANQP_CACHE_NAI_REALM,
+				anqp_add_nai_realm_list);
+	else if (request & (ANQP_REQ_NAI_REALM | ANQP_REQ_NAI_HOME_REALM))
 		anqp_add_nai_realm(hapd, buf, home_realm, home_realm_len,
 				   request & ANQP_REQ_NAI_REALM,
 				   request & ANQP_REQ_NAI_HOME_REALM);
 	if (request & ANQP_REQ_3GPP_CELLULAR_NETWORK)
-		anqp_add_3gpp_cellular_network(hapd, buf);
+		anqp_add_cached(hapd, buf, ANQP_CACHE_3GPP_CELLULAR_NETWORK,
+				anqp_add_3gpp_cellular_network);
 	if (request & ANQP_REQ_AP_GEOSPATIAL_LOCATION)
 		anqp_add_elem(hapd, buf, ANQP_AP_GEOSPATIAL_LOCATION);
 	if (request & ANQP_REQ_AP_CIVIC_LOCATION)
@@ -784,7 +904,8 @@ gas_serv_build_gas_resp_payload(struct hostapd_data *hapd,
 	if (request & ANQP_REQ_AP_LOCATION_PUBLIC_URI)
 		anqp_add_elem(hapd, buf, ANQP_AP_LOCATION_PUBLIC_URI);
 	if (request & ANQP_REQ_DOMAIN_NAME)
-		anqp_add_domain_name(hapd, buf);
+		anqp_add_cached(hapd, buf, ANQP_CACHE_DOMAIN_NAME,
+				anqp_add_domain_name);
 	if (request & ANQP_REQ_EMERGENCY_ALERT_URI)
 		anqp_add_elem(hapd, buf, ANQP_EMERGENCY_ALERT_URI);
 	if (request & ANQP_REQ_TDLS_CAPABILITY)
@@ -795,12 +916,14 @@ gas_serv_build_gas_resp_payload(struct hostapd_data *hapd,
 	for (i = 0; i < num_extra_req; i++) {
 #ifdef CONFIG_FILS
 		if (extra_req[i] == ANQP_FILS_REALM_INFO) {
-			anqp_add_fils_realm_info(hapd, buf);
+			anqp_add_cached(hapd, buf, ANQP_CACHE_FILS_REALM_INFO,
+					anqp_add_fils_realm_info);
 			continue;
 		}
 #endif /* CONFIG_FILS */
 		if (extra_req[i] == ANQP_VENUE_URL) {
-			anqp_add_venue_url(hapd, buf);
+			anqp_add_cached(hapd, buf, ANQP_CACHE_VENUE_URL,
+					anqp_add_venue_url);
 			continue;
 		}
 		anqp_add_elem(hapd, buf, extra_req[i]);
@@ -808,20 +931,26 @@ gas_serv_build_gas_resp_payload(struct hostapd_data *hapd,
 
 #ifdef CONFIG_HS20
 	if (request & ANQP_REQ_HS_CAPABILITY_LIST)
-		anqp_add_hs_capab_list(hapd, buf);
+		anqp_add_cached(hapd, buf, ANQP_CACHE_HS_CAPABILITY_LIST,
+				anqp_add_hs_capab_list);
 	if (request & ANQP_REQ_OPERATOR_FRIENDLY_NAME)
-		anqp_add_operator_friendly_name(hapd, buf);
+		anqp_add_cached(hapd, buf, ANQP_CACHE_OPERATOR_FRIENDLY_NAME,
+				anqp_add_operator_friendly_name);
 	if (request & ANQP_REQ_WAN_METRICS)
-		anqp_add_wan_metrics(hapd, buf);
+		anqp_add_cached(hapd, buf, ANQP_CACHE_WAN_METRICS,
+				anqp_add_wan_metrics);
 	if (request & ANQP_REQ_CONNECTION_CAPABILITY)
-		anqp_add_connection_capability(hapd, buf);
+		anqp_add_cached(hapd, buf, ANQP_CACHE_CONNECTION_CAPABILITY,
+				anqp_add_connection_capability);
 	if (request & ANQP_REQ_OPERATING_CLASS)
-		anqp_add_operating_class(hapd, buf);
+		anqp_add_cached(hapd, buf, ANQP_CACHE_OPERATING_CLASS,
+				anqp_add_operating_class);
 #endif /* CONFIG_HS20 */
 
 #ifdef CONFIG_MBO
 	if (request & ANQP_REQ_MBO_CELL_DATA_CONN_PREF)
-		anqp_add_mbo_cell_data_conn_pref(hapd, buf);
+		anqp_add_cached(hapd, buf, ANQP_CACHE_MBO_CELL_DATA_CONN_PREF,
+				anqp_add_mbo_cell_data_conn_pref);
 #endif /* CONFIG_MBO */
 
 	return buf;
@@ -1602,6 +1731,11 @@ static void gas_serv_rx_public_action(void *ctx, const u8 *buf, size_t len,
 
 int gas_serv_init(struct hostapd_data *hapd)
 {
+	if (!hapd->anqp_cache) {
+		hapd->anqp_cache = os_zalloc(sizeof(*hapd->anqp_cache));
+		if (!hapd->anqp_cache)
+			return -1;
+	}
 	hapd->public_action_cb2 = gas_serv_rx_public_action;
 	hapd->public_action_cb2_ctx = hapd;
 	return 0;
@@ -1610,4 +1744,7 @@ int gas_serv_init(struct hostapd_data *hapd)
 
 void gas_serv_deinit(struct hostapd_data *hapd)
 {
+	gas_serv_anqp_cache_flush(hapd);
+	os_free(hapd->anqp_cache);
+	hapd->anqp_cache = NULL;
 }
@@ -87,6 +87,8 @@ void gas_serv_dialog_clear(struct gas_dialog_info *dialog);
 
 int gas_serv_init(struct hostapd_data *hapd);
 void gas_serv_deinit(struct hostapd_data *hapd);
+void gas_serv_anqp_cache_flush(struct hostapd_data *hapd);
+int gas_serv_get_mib(struct hostapd_data *hapd, char *buf, size_t buflen);
 
 void gas_serv_req_dpp_processing(struct hostapd_data *hapd,
 				 const u8 *sa, u8 dialog_token,
@@ -143,6 +143,10 @@ static void hostapd_reload_bss(struct hostapd_data *hapd)
 	radius_client_reconfig(hapd->radius, hapd->conf->radius);
 #endif /* CONFIG_NO_RADIUS */
 
+#if defined(CONFIG_INTERWORKING) || defined(CONFIG_DPP)
+	gas_serv_anqp_cache_flush(hapd);
+#endif /* CONFIG_INTERWORKING || CONFIG_DPP */
+
 	ssid = &hapd->conf->ssid;
 	if (!ssid->wpa_psk_set && ssid->wpa_psk && !ssid->wpa_psk->next &&
 	    ssid->wpa_passphrase_set && ssid->wpa_passphrase) {
@@ -469,6 +473,7 @@ void hostapd_free_hapd_data(struct hostapd_data *hapd)
 	wpabuf_free(hapd->p2p_probe_resp_ie);
 	hapd->p2p_probe_resp_ie = NULL;
 #endif /* CONFIG_P2P */
+	hostapd_beacon_tmpl_flush(hapd);
 
 	if (!hapd->started) {
 		wpa_printf(MSG_ERROR, "%s: Interface %s wasn't started",
@@ -225,8 +225,7 @@ struct hostapd_data {
 	u64 acct_session_id;
 	struct radius_das_data *radius_das;
 
-	struct hostapd_cached_radius_acl *acl_cache;
-	struct hostapd_acl_query_data *acl_queries;
+	struct hostapd_acl_data *acl; /* RADIUS ACL cache and pending queries */
 
 	struct wpa_authenticator *wpa_auth;
 	struct eapol_authenticator *eapol_auth;
@@ -271,6 +270,9 @@ struct hostapd_data {
 	struct wps_context *wps;
 
 	int beacon_set_done;
+	/* Serialized copy of the AP parameters last accepted by the driver;
+	 * used to skip redundant Beacon template updates */
+	struct wpabuf *beacon_tmpl;
 	struct wpabuf *wps_beacon_ie;
 	struct wpabuf *wps_probe_resp_ie;
 #ifdef CONFIG_WPS
@@ -295,6 +297,8 @@ struct hostapd_data {
 	void (*public_action_cb2)(void *ctx, const u8 *buf, size_t len,
 				  int freq);
 	void *public_action_cb2_ctx;
+	/* Serialized ANQP elements built from the current configuration */
+	struct gas_serv_anqp_cache *anqp_cache;
 
 	int (*vendor_action_cb)(void *ctx, const u8 *buf, size_t len,
 				int freq);
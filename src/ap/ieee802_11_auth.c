@@ -27,24 +27,29 @@
 #include "ieee802_11_auth.h"
 
 #define RADIUS_ACL_TIMEOUT 30
+#define RADIUS_ACL_MAX_CACHE 4096
+#define ACL_HASH_SIZE 64
+#define ACL_HASH(addr) ((addr)[5] & (ACL_HASH_SIZE - 1))
 
 
 struct hostapd_cached_radius_acl {
+	struct dl_list list; /* struct hostapd_acl_data::cache */
+	struct dl_list hlist; /* struct hostapd_acl_data::cache_hash */
 	struct os_reltime timestamp;
 	macaddr addr;
 	int accepted; /* HOSTAPD_ACL_* */
-	struct hostapd_cached_radius_acl *next;
 	struct radius_sta info;
 };
 
 
 struct hostapd_acl_query_data {
+	struct dl_list list; /* struct hostapd_acl_data::queries */
+	struct dl_list hlist; /* struct hostapd_acl_data::query_hash */
 	struct os_reltime timestamp;
 	u8 radius_id;
 	macaddr addr;
 	u8 *auth_msg; /* IEEE 802.11 authentication frame from station */
 	size_t auth_msg_len;
-	struct hostapd_acl_query_data *next;
 	bool radius_psk;
 	int akm;
 	u8 *anonce;
@@ -53,6 +58,19 @@ struct hostapd_acl_query_data {
 };
 
 
+struct hostapd_acl_data {
+	/* Cached RADIUS ACL results in the order they were added, i.e., the
+	 * oldest entry, which will expire first, is at the head of the list */
+	struct dl_list cache;
+	struct dl_list cache_hash[ACL_HASH_SIZE];
+	unsigned int num_cache;
+
+	/* Pending RADIUS ACL queries, oldest first */
+	struct dl_list queries;
+	struct dl_list query_hash[ACL_HASH_SIZE];
+};
+
+
 #ifndef CONFIG_NO_RADIUS
 static void hostapd_acl_cache_free_entry(struct hostapd_cached_radius_acl *e)
 {
@@ -63,15 +81,55 @@ static void hostapd_acl_cache_free_entry(struct hostapd_cached_radius_acl *e)
 }
 
 
-static void hostapd_acl_cache_free(struct hostapd_cached_radius_acl *acl_cache)
+static void hostapd_acl_cache_del(struct hostapd_acl_data *acl,
+				  struct hostapd_cached_radius_acl *entry)
 {
-	struct hostapd_cached_radius_acl *prev;
+	dl_list_del(&entry->list);
+	dl_list_del(&entry->hlist);
+	acl->num_cache--;
+	hostapd_acl_cache_free_entry(entry);
+}
+
 
-	while (acl_cache) {
-		prev = acl_cache;
-		acl_cache = acl_cache->next;
-		hostapd_acl_cache_free_entry(prev);
+static struct hostapd_cached_radius_acl *
+hostapd_acl_cache_find(struct hostapd_acl_data *acl, const u8 *addr)
+{
+	struct hostapd_cached_radius_acl *entry;
+
+	dl_list_for_each(entry, &acl->cache_hash[ACL_HASH(addr)],
+			 struct hostapd_cached_radius_acl, hlist) {
+		if (ether_addr_equal(entry->addr, addr))
+			return entry;
 	}
+
+	return NULL;
+}
+
+
+static void hostapd_acl_cache_add(struct hostapd_data *hapd,
+				  struct hostapd_cached_radius_acl *cache)
+{
+	struct hostapd_acl_data *acl = hapd->acl;
+	struct hostapd_cached_radius_acl *entry;
+
+	/* Replace any older result for the same station */
+	entry = hostapd_acl_cache_find(acl, cache->addr);
+	if (entry)
+		hostapd_acl_cache_del(acl, entry);
+
+	if (acl->num_cache >= RADIUS_ACL_MAX_CACHE) {
+		entry = dl_list_first(&acl->cache,
+				      struct hostapd_cached_radius_acl, list);
+		wpa_printf(MSG_DEBUG, "Removing oldest cached ACL entry for "
+			   MACSTR " to make room for a new entry",
+			   MAC2STR(entry->addr));
+		hostapd_drv_set_radius_acl_expire(hapd, entry->addr);
+		hostapd_acl_cache_del(acl, entry);
+	}
+
+	dl_list_add_tail(&acl->cache, &cache->list);
+	dl_list_add(&acl->cache_hash[ACL_HASH(cache->addr)], &cache->hlist);
+	acl->num_cache++;
 }
 
 
@@ -81,21 +139,16 @@ static int hostapd_acl_cache_get(struct hostapd_data *hapd, const u8 *addr,
 	struct hostapd_cached_radius_acl *entry;
 	struct os_reltime now;
 
-	os_get_reltime(&now);
-
-	for (entry = hapd->acl_cache; entry; entry = entry->next) {
-		if (!ether_addr_equal(entry->addr, addr))
-			continue;
-
-		if (os_reltime_expired(&now, &entry->timestamp,
-				       RADIUS_ACL_TIMEOUT))
-			return -1; /* entry has expired */
-		*out = entry->info;
+	entry = hostapd_acl_cache_find(hapd->acl, addr);
+	if (!entry)
+		return -1;
 
-		return entry->accepted;
-	}
+	os_get_reltime(&now);
+	if (os_reltime_expired(&now, &entry->timestamp, RADIUS_ACL_TIMEOUT))
+		return -1; /* entry has expired */
+	*out = entry->info;
 
-	return -1;
+	return entry->accepted;
 }
 #endif /* CONFIG_NO_RADIUS */
 
@@ -111,6 +164,24 @@ static void hostapd_acl_query_free(struct hostapd_acl_query_data *query)
 }
 
 
+#ifndef CONFIG_NO_RADIUS
+static void hostapd_acl_query_add(struct hostapd_acl_data *acl,
+				  struct hostapd_acl_query_data *query)
+{
+	dl_list_add_tail(&acl->queries, &query->list);
+	dl_list_add(&acl->query_hash[ACL_HASH(query->addr)], &query->hlist);
+}
+#endif /* CONFIG_NO_RADIUS */
+
+
+static void hostapd_acl_query_del(struct hostapd_acl_query_data *query)
+{
+	dl_list_del(&query->list);
+	dl_list_del(&query->hlist);
+	hostapd_acl_query_free(query);
+}
+
+
 #ifndef CONFIG_NO_RADIUS
 static int hostapd_radius_acl_query(struct hostapd_data *hapd, const u8 *addr,
 				    struct hostapd_acl_query_data *query)
@@ -282,14 +353,13 @@ int hostapd_allowed_address(struct hostapd_data *hapd, const u8 *addr,
 		if (res == HOSTAPD_ACL_REJECT)
 			return HOSTAPD_ACL_REJECT;
 
-		query = hapd->acl_queries;
-		while (query) {
+		dl_list_for_each(query, &hapd->acl->query_hash[ACL_HASH(addr)],
+				 struct hostapd_acl_query_data, hlist) {
 			if (ether_addr_equal(query->addr, addr)) {
 				/* pending query in RADIUS retransmit queue;
 				 * do not generate a new one */
 				return HOSTAPD_ACL_PENDING;
 			}
-			query = query->next;
 		}
 
 		if (!hapd->conf->radius->auth_server)
@@ -318,8 +388,7 @@ int hostapd_allowed_address(struct hostapd_data *hapd, const u8 *addr,
 			return HOSTAPD_ACL_REJECT;
 		}
 		query->auth_msg_len = len;
-		query->next = hapd->acl_queries;
-		hapd->acl_queries = query;
+		hostapd_acl_query_add(hapd->acl, query);
 
 		/* Queued data will be processed in hostapd_acl_recv_radius()
 		 * when RADIUS server replies to the sent Access-Request. */
@@ -335,29 +404,20 @@ int hostapd_allowed_address(struct hostapd_data *hapd, const u8 *addr,
 static void hostapd_acl_expire_cache(struct hostapd_data *hapd,
 				     struct os_reltime *now)
 {
-	struct hostapd_cached_radius_acl *prev, *entry, *tmp;
-
-	prev = NULL;
-	entry = hapd->acl_cache;
-
-	while (entry) {
-		if (os_reltime_expired(now, &entry->timestamp,
-				       RADIUS_ACL_TIMEOUT)) {
-			wpa_printf(MSG_DEBUG, "Cached ACL entry for " MACSTR
-				   " has expired.", MAC2STR(entry->addr));
-			if (prev)
-				prev->next = entry->next;
-			else
-				hapd->acl_cache = entry->next;
-			hostapd_drv_set_radius_acl_expire(hapd, entry->addr);
-			tmp = entry;
-			entry = entry->next;
-			hostapd_acl_cache_free_entry(tmp);
-			continue;
-		}
+	struct hostapd_cached_radius_acl *entry;
 
-		prev = entry;
-		entry = entry->next;
+	/* Entries are in timestamp order, so stop at the first one that is
+	 * still valid */
+	while ((entry = dl_list_first(&hapd->acl->cache,
+				      struct hostapd_cached_radius_acl,
+				      list))) {
+		if (!os_reltime_expired(now, &entry->timestamp,
+					RADIUS_ACL_TIMEOUT))
+			break;
+		wpa_printf(MSG_DEBUG, "Cached ACL entry for " MACSTR
+			   " has expired.", MAC2STR(entry->addr));
+		hostapd_drv_set_radius_acl_expire(hapd, entry->addr);
+		hostapd_acl_cache_del(hapd->acl, entry);
 	}
 }
 
@@ -365,29 +425,16 @@ static void hostapd_acl_expire_cache(struct hostapd_data *hapd,
 static void hostapd_acl_expire_queries(struct hostapd_data *hapd,
 				       struct os_reltime *now)
 {
-	struct hostapd_acl_query_data *prev, *entry, *tmp;
-
-	prev = NULL;
-	entry = hapd->acl_queries;
-
-	while (entry) {
-		if (os_reltime_expired(now, &entry->timestamp,
-				       RADIUS_ACL_TIMEOUT)) {
-			wpa_printf(MSG_DEBUG, "ACL query for " MACSTR
-				   " has expired.", MAC2STR(entry->addr));
-			if (prev)
-				prev->next = entry->next;
-			else
-				hapd->acl_queries = entry->next;
-
-			tmp = entry;
-			entry = entry->next;
-			hostapd_acl_query_free(tmp);
-			continue;
-		}
+	struct hostapd_acl_query_data *entry;
 
-		prev = entry;
-		entry = entry->next;
+	while ((entry = dl_list_first(&hapd->acl->queries,
+				      struct hostapd_acl_query_data, list))) {
+		if (!os_reltime_expired(now, &entry->timestamp,
+					RADIUS_ACL_TIMEOUT))
+			break;
+		wpa_printf(MSG_DEBUG, "ACL query for " MACSTR
+			   " has expired.", MAC2STR(entry->addr));
+		hostapd_acl_query_del(entry);
 	}
 }
 
@@ -400,6 +447,9 @@ void hostapd_acl_expire(struct hostapd_data *hapd)
 {
 	struct os_reltime now;
 
+	if (!hapd->acl)
+		return;
+
 	os_get_reltime(&now);
 	hostapd_acl_expire_cache(hapd, &now);
 	hostapd_acl_expire_queries(hapd, &now);
@@ -488,18 +538,18 @@ hostapd_acl_recv_radius(struct radius_msg *msg, struct radius_msg *req,
 			void *data)
 {
 	struct hostapd_data *hapd = data;
-	struct hostapd_acl_query_data *query, *prev;
+	struct hostapd_acl_query_data *query, *tmp;
 	struct hostapd_cached_radius_acl *cache;
 	struct radius_sta *info;
 	struct radius_hdr *hdr = radius_msg_get_hdr(msg);
 
-	query = hapd->acl_queries;
-	prev = NULL;
-	while (query) {
-		if (query->radius_id == hdr->identifier)
+	query = NULL;
+	dl_list_for_each(tmp, &hapd->acl->queries,
+			 struct hostapd_acl_query_data, list) {
+		if (tmp->radius_id == hdr->identifier) {
+			query = tmp;
 			break;
-		prev = query;
-		query = query->next;
+		}
 	}
 	if (!query)
 		return RADIUS_RX_UNKNOWN;
@@ -596,8 +646,7 @@ hostapd_acl_recv_radius(struct radius_msg *msg, struct radius_msg *req,
 			cache->accepted = HOSTAPD_ACL_REJECT;
 	} else
 		cache->accepted = HOSTAPD_ACL_REJECT;
-	cache->next = hapd->acl_cache;
-	hapd->acl_cache = cache;
+	hostapd_acl_cache_add(hapd, cache);
 
 	if (query->radius_psk) {
 		struct sta_info *sta;
@@ -636,12 +685,7 @@ hostapd_acl_recv_radius(struct radius_msg *msg, struct radius_msg *req,
 	}
 
  done:
-	if (!prev)
-		hapd->acl_queries = query->next;
-	else
-		prev->next = query->next;
-
-	hostapd_acl_query_free(query);
+	hostapd_acl_query_del(query);
 
 	return RADIUS_RX_PROCESSED;
 }
@@ -655,6 +699,22 @@ hostapd_acl_recv_radius(struct radius_msg *msg, struct radius_msg *req,
  */
 int hostapd_acl_init(struct hostapd_data *hapd)
 {
+	struct hostapd_acl_data *acl;
+	int i;
+
+	if (!hapd->acl) {
+		acl = os_zalloc(sizeof(*acl));
+		if (!acl)
+			return -1;
+		dl_list_init(&acl->cache);
+		dl_list_init(&acl->queries);
+		for (i = 0; i < ACL_HASH_SIZE; i++) {
+			dl_list_init(&acl->cache_hash[i]);
+			dl_list_init(&acl->query_hash[i]);
+		}
+		hapd->acl = acl;
+	}
+
 #ifndef CONFIG_NO_RADIUS
 	if (radius_client_register(hapd->radius, RADIUS_AUTH,
 				   hostapd_acl_recv_radius, hapd))
@@ -671,20 +731,27 @@ int hostapd_acl_init(struct hostapd_data *hapd)
  */
 void hostapd_acl_deinit(struct hostapd_data *hapd)
 {
-	struct hostapd_acl_query_data *query, *prev;
+	struct hostapd_acl_data *acl = hapd->acl;
+	struct hostapd_acl_query_data *query;
+#ifndef CONFIG_NO_RADIUS
+	struct hostapd_cached_radius_acl *entry;
+#endif /* CONFIG_NO_RADIUS */
+
+	if (!acl)
+		return;
 
 #ifndef CONFIG_NO_RADIUS
-	hostapd_acl_cache_free(hapd->acl_cache);
-	hapd->acl_cache = NULL;
+	while ((entry = dl_list_first(&acl->cache,
+				      struct hostapd_cached_radius_acl, list)))
+		hostapd_acl_cache_del(acl, entry);
 #endif /* CONFIG_NO_RADIUS */
 
-	query = hapd->acl_queries;
-	hapd->acl_queries = NULL;
-	while (query) {
-		prev = query;
-		query = query->next;
-		hostapd_acl_query_free(prev);
-	}
+	while ((query = dl_list_first(&acl->queries,
+				      struct hostapd_acl_query_data, list)))
+		hostapd_acl_query_del(query);
+
+	os_free(acl);
+	hapd->acl = NULL;
 }
 
 
@@ -745,7 +812,6 @@ void hostapd_acl_req_radius_psk(struct hostapd_data *hapd, const u8 *addr,
 		return;
 	}
 
-	query->next = hapd->acl_queries;
-	hapd->acl_queries = query;
+	hostapd_acl_query_add(hapd->acl, query);
 }
 #endif /* CONFIG_NO_RADIUS */
@@ -52,11 +52,48 @@ static void ieee802_1x_send(struct hostapd_data *hapd, struct sta_info *sta,
 			    u8 type, const u8 *data, size_t datalen)
 {
 	u8 *buf;
-	struct ieee802_1x_hdr *xhdr;
+	struct ieee802_1x_hdr xhdr;
 	size_t len;
 	int encrypt = 0;
+	bool contiguous = !!(sta->flags & WLAN_STA_PREAUTH);
 
-	len = sizeof(*xhdr) + datalen;
+	os_memset(&xhdr, 0, sizeof(xhdr));
+	xhdr.version = hapd->conf->eapol_version;
+#ifdef CONFIG_MACSEC
+	if (xhdr.version > 2 && hapd->conf->macsec_policy == 0)
+		xhdr.version = 2;
+#endif /* CONFIG_MACSEC */
+	xhdr.type = type;
+	xhdr.length = host_to_be16(datalen);
+
+	if (wpa_auth_pairwise_set(sta->wpa_sm))
+		encrypt = 1;
+#ifdef CONFIG_TESTING_OPTIONS
+	if (hapd->ext_eapol_frame_io)
+		contiguous = true;
+#endif /* CONFIG_TESTING_OPTIONS */
+
+	if (!contiguous && (data || !datalen)) {
+		const u8 *elem[2];
+		size_t elem_len[2];
+		int link_id = -1;
+
+#ifdef CONFIG_IEEE80211BE
+		link_id = hapd->conf->mld_ap ? hapd->mld_link_id : -1;
+#endif /* CONFIG_IEEE80211BE */
+		/* Pass the header and the payload to the driver as is to
+		 * avoid building a copy of the frame */
+		elem[0] = (const u8 *) &xhdr;
+		elem_len[0] = sizeof(xhdr);
+		elem[1] = data;
+		elem_len[1] = datalen;
+		hostapd_drv_hapd_send_eapol_vector(
+			hapd, sta->addr, datalen ? 2 : 1, elem, elem_len,
+			encrypt, hostapd_sta_flags_to_drv(sta->flags), link_id);
+		return;
+	}
+
+	len = sizeof(xhdr) + datalen;
 	buf = os_zalloc(len);
 	if (!buf) {
 		wpa_printf(MSG_ERROR, "malloc() failed for %s(len=%lu)",
@@ -64,20 +101,10 @@ static void ieee802_1x_send(struct hostapd_data *hapd, struct sta_info *sta,
 		return;
 	}
 
-	xhdr = (struct ieee802_1x_hdr *) buf;
-	xhdr->version = hapd->conf->eapol_version;
-#ifdef CONFIG_MACSEC
-	if (xhdr->version > 2 && hapd->conf->macsec_policy == 0)
-		xhdr->version = 2;
-#endif /* CONFIG_MACSEC */
-	xhdr->type = type;
-	xhdr->length = host_to_be16(datalen);
-
+	os_memcpy(buf, &xhdr, sizeof(xhdr));
 	if (datalen > 0 && data != NULL)
-		os_memcpy(xhdr + 1, data, datalen);
+		os_memcpy(buf + sizeof(xhdr), data, datalen);
 
-	if (wpa_auth_pairwise_set(sta->wpa_sm))
-		encrypt = 1;
 #ifdef CONFIG_TESTING_OPTIONS
 	if (hapd->ext_eapol_frame_io) {
 		size_t hex_len = 2 * len + 1;
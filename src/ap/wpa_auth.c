@@ -985,6 +985,9 @@ int wpa_reconfig(struct wpa_authenticator *wpa_auth,
 
 	wpa_auth_free_conf(&wpa_auth->conf);
 	os_memcpy(&wpa_auth->conf, conf, sizeof(*conf));
+#ifdef CONFIG_IEEE80211R_AP
+	wpa_ft_rkh_list_changed(wpa_auth);
+#endif /* CONFIG_IEEE80211R_AP */
 	if (wpa_auth_gen_wpa_ie(wpa_auth)) {
 		wpa_printf(MSG_ERROR, "Could not generate WPA IE.");
 		return -1;
@@ -1122,6 +1125,7 @@ static void wpa_free_sta_sm(struct wpa_state_machine *sm)
 	wpabuf_free(sm->ft_pending_req_ies);
 #endif /* CONFIG_IEEE80211R_AP */
 	os_free(sm->last_rx_eapol_key);
+	bin_clear_free(sm->eapol_tx_buf, sm->eapol_tx_buf_len);
 	os_free(sm->wpa_ie);
 	os_free(sm->rsnxe);
 	os_free(sm->rsn_selection);
@@ -2044,6 +2048,30 @@ static void wpa_send_eapol_timeout(void *eloop_ctx, void *timeout_ctx)
 }
 
 
+static struct ieee802_1x_hdr *
+wpa_auth_eapol_tx_buf(struct wpa_state_machine *sm, size_t len)
+{
+	/* EAPOL-Key frames are built in a per-STA buffer that is reused for
+	 * retransmissions and group rekeying instead of allocating a new one
+	 * for each frame. */
+	if (len > sm->eapol_tx_buf_len) {
+		size_t alloc_len = len;
+
+		if (alloc_len < WPA_AUTH_EAPOL_TX_BUF_LEN)
+			alloc_len = WPA_AUTH_EAPOL_TX_BUF_LEN;
+		bin_clear_free(sm->eapol_tx_buf, sm->eapol_tx_buf_len);
+		sm->eapol_tx_buf_len = 0;
+		sm->eapol_tx_buf = os_malloc(alloc_len);
+		if (!sm->eapol_tx_buf)
+			return NULL;
+		sm->eapol_tx_buf_len = alloc_len;
+	}
+
+	os_memset(sm->eapol_tx_buf, 0, len);
+	return (struct ieee802_1x_hdr *) sm->eapol_tx_buf;
+}
+
+
 void __wpa_send_eapol(struct wpa_authenticator *wpa_auth,
 		      struct wpa_state_machine *sm, int key_info,
 		      const u8 *key_rsc, const u8 *nonce,
@@ -2103,7 +2131,7 @@ void __wpa_send_eapol(struct wpa_authenticator *wpa_auth,
 	if (!mic_len && encr)
 		len += AES_BLOCK_SIZE;
 
-	hdr = os_zalloc(len);
+	hdr = wpa_auth_eapol_tx_buf(sm, len);
 	if (!hdr)
 		return;
 	hdr->version = conf->eapol_version;
@@ -2182,10 +2210,8 @@ void __wpa_send_eapol(struct wpa_authenticator *wpa_auth,
 #endif /* CONFIG_FILS */
 	} else if (encr && kde) {
 		buf = os_zalloc(key_data_len);
-		if (!buf) {
-			os_free(hdr);
+		if (!buf)
 			return;
-		}
 		pos = buf;
 		os_memcpy(pos, kde, kde_len);
 		pos += kde_len;
@@ -2203,7 +2229,6 @@ void __wpa_send_eapol(struct wpa_authenticator *wpa_auth,
 					sm->PTK.kek, sm->PTK.kek_len);
 			if (aes_wrap(sm->PTK.kek, sm->PTK.kek_len,
 				     (key_data_len - 8) / 8, buf, key_data)) {
-				os_free(hdr);
 				bin_clear_free(buf, key_data_len);
 				return;
 			}
@@ -2227,7 +2252,6 @@ void __wpa_send_eapol(struct wpa_authenticator *wpa_auth,
 			WPA_PUT_BE16(key_mic + mic_len, key_data_len);
 #endif /* !(CONFIG_NO_RC4 || CONFIG_FIPS) */
 		} else {
-			os_free(hdr);
 			bin_clear_free(buf, key_data_len);
 			return;
 		}
@@ -2239,16 +2263,13 @@ void __wpa_send_eapol(struct wpa_authenticator *wpa_auth,
 			wpa_auth_logger(wpa_auth, wpa_auth_get_spa(sm),
 					LOGGER_DEBUG,
 					"PTK not valid when sending EAPOL-Key frame");
-			os_free(hdr);
 			return;
 		}
 
 		if (wpa_eapol_key_mic(sm->PTK.kck, sm->PTK.kck_len,
 				      sm->wpa_key_mgmt, version,
-				      (u8 *) hdr, len, key_mic) < 0) {
-			os_free(hdr);
+				      (u8 *) hdr, len, key_mic) < 0)
 			return;
-		}
 #ifdef CONFIG_TESTING_OPTIONS
 		if (!pairwise &&
 		    conf->corrupt_gtk_rekey_mic_probability > 0.0 &&
@@ -2265,7 +2286,6 @@ void __wpa_send_eapol(struct wpa_authenticator *wpa_auth,
 	wpa_hexdump(MSG_DEBUG, "Send EAPOL-Key msg", hdr, len);
 	wpa_auth_send_eapol(wpa_auth, sm->addr, (u8 *) hdr, len,
 			sm->pairwise_set);
-	os_free(hdr);
 }
 
 
@@ -6334,6 +6354,11 @@ int wpa_get_mib(struct wpa_authenticator *wpa_auth, char *buf, size_t buflen)
 		return len;
 	len += ret;
 
+#ifdef CONFIG_IEEE80211R_AP
+	len += wpa_ft_pmk_cache_get_mib(wpa_auth->ft_pmk_cache, buf + len,
+					buflen - len);
+#endif /* CONFIG_IEEE80211R_AP */
+
 	return len;
 }
 
@@ -151,6 +151,7 @@ struct wpa_channel_info;
 
 struct ft_remote_r0kh {
 	struct ft_remote_r0kh *next;
+	struct ft_remote_r0kh *hnext; /* next entry in wpa_auth->r0kh_hash */
 	u8 addr[ETH_ALEN];
 	u8 id[FT_R0KH_ID_MAX_LEN];
 	size_t id_len;
@@ -161,6 +162,7 @@ struct ft_remote_r0kh {
 
 struct ft_remote_r1kh {
 	struct ft_remote_r1kh *next;
+	struct ft_remote_r1kh *hnext; /* next entry in wpa_auth->r1kh_hash */
 	u8 addr[ETH_ALEN];
 	u8 id[FT_R1KH_ID_LEN];
 	u8 key[32];
@@ -572,6 +574,8 @@ void wpa_ft_rrb_oui_rx(struct wpa_authenticator *wpa_auth, const u8 *src_addr,
 		       size_t data_len);
 void wpa_ft_push_pmk_r1(struct wpa_authenticator *wpa_auth, const u8 *addr);
 void wpa_ft_deinit(struct wpa_authenticator *wpa_auth);
+void wpa_ft_rkh_list_changed(struct wpa_authenticator *wpa_auth);
+int wpa_ft_rkh_module_tests(void);
 void wpa_ft_sta_deinit(struct wpa_state_machine *sm);
 int wpa_ft_fetch_pmk_r1(struct wpa_authenticator *wpa_auth,
 			const u8 *spa, const u8 *pmk_r1_name,
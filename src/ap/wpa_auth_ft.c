@@ -1202,6 +1202,7 @@ static int wpa_ft_new_seq(struct ft_remote_seq *rkh_seq,
 
 struct wpa_ft_pmk_r0_sa {
 	struct dl_list list;
+	struct dl_list hlist; /* entry in wpa_ft_pmk_cache::pmk_r0_hash */
 	u8 pmk_r0[PMK_LEN_MAX];
 	size_t pmk_r0_len;
 	u8 pmk_r0_name[WPA_PMK_NAME_LEN];
@@ -1220,12 +1221,14 @@ struct wpa_ft_pmk_r0_sa {
 
 struct wpa_ft_pmk_r1_sa {
 	struct dl_list list;
+	struct dl_list hlist; /* entry in wpa_ft_pmk_cache::pmk_r1_hash */
 	u8 pmk_r1[PMK_LEN_MAX];
 	size_t pmk_r1_len;
 	u8 pmk_r1_name[WPA_PMK_NAME_LEN];
 	u8 spa[ETH_ALEN];
 	int pairwise; /* Pairwise cipher suite, WPA_CIPHER_* */
 	struct vlan_description *vlan;
+	os_time_t expiration; /* 0 for no expiration */
 	u8 *identity;
 	size_t identity_len;
 	u8 *radius_cui;
@@ -1234,14 +1237,28 @@ struct wpa_ft_pmk_r1_sa {
 	/* TODO: radius_class, EAP type */
 };
 
+#define FT_PMK_HASH_SIZE 256
+#define FT_PMK_HASH(spa) ((spa)[5])
+
 struct wpa_ft_pmk_cache {
 	struct dl_list pmk_r0; /* struct wpa_ft_pmk_r0_sa */
 	struct dl_list pmk_r1; /* struct wpa_ft_pmk_r1_sa */
+	struct dl_list pmk_r0_hash[FT_PMK_HASH_SIZE]; /* by SPA */
+	struct dl_list pmk_r1_hash[FT_PMK_HASH_SIZE]; /* by SPA */
+
+	/* Statistics */
+	unsigned int pmk_r0_hits;
+	unsigned int pmk_r0_misses;
+	unsigned int pmk_r1_hits;
+	unsigned int pmk_r1_misses;
+	unsigned int pmk_r1_pulls;
+	unsigned int pmk_r1_pull_resps;
+	unsigned int pmk_r1_pull_latency_max; /* in ms */
+	u64 pmk_r1_pull_latency_total; /* in ms */
 };
 
 
-static void wpa_ft_expire_pmk_r0(void *eloop_ctx, void *timeout_ctx);
-static void wpa_ft_expire_pmk_r1(void *eloop_ctx, void *timeout_ctx);
+static void wpa_ft_pmk_cache_expire(void *eloop_ctx, void *timeout_ctx);
 
 
 static void wpa_ft_free_pmk_r0(struct wpa_ft_pmk_r0_sa *r0)
@@ -1250,7 +1267,7 @@ static void wpa_ft_free_pmk_r0(struct wpa_ft_pmk_r0_sa *r0)
 		return;
 
 	dl_list_del(&r0->list);
-	eloop_cancel_timeout(wpa_ft_expire_pmk_r0, r0, NULL);
+	dl_list_del(&r0->hlist);
 
 	os_memset(r0->pmk_r0, 0, PMK_LEN_MAX);
 	os_free(r0->vlan);
@@ -1260,51 +1277,13 @@ static void wpa_ft_free_pmk_r0(struct wpa_ft_pmk_r0_sa *r0)
 }
 
 
-static void wpa_ft_expire_pmk_r0(void *eloop_ctx, void *timeout_ctx)
-{
-	struct wpa_ft_pmk_r0_sa *r0 = eloop_ctx;
-	struct os_reltime now;
-	int expires_in;
-	int session_timeout;
-
-	os_get_reltime(&now);
-
-	if (!r0)
-		return;
-
-	expires_in = r0->expiration - now.sec;
-	session_timeout = r0->session_timeout - now.sec;
-	/* conditions to remove from cache:
-	 * a) r0->expiration is set and hit
-	 * -or-
-	 * b) r0->session_timeout is set and hit
-	 */
-	if ((!r0->expiration || expires_in > 0) &&
-	    (!r0->session_timeout || session_timeout > 0)) {
-		wpa_printf(MSG_ERROR,
-			   "FT: %s() called for non-expired entry %p",
-			   __func__, r0);
-		eloop_cancel_timeout(wpa_ft_expire_pmk_r0, r0, NULL);
-		if (r0->expiration && expires_in > 0)
-			eloop_register_timeout(expires_in + 1, 0,
-					       wpa_ft_expire_pmk_r0, r0, NULL);
-		if (r0->session_timeout && session_timeout > 0)
-			eloop_register_timeout(session_timeout + 1, 0,
-					       wpa_ft_expire_pmk_r0, r0, NULL);
-		return;
-	}
-
-	wpa_ft_free_pmk_r0(r0);
-}
-
-
 static void wpa_ft_free_pmk_r1(struct wpa_ft_pmk_r1_sa *r1)
 {
 	if (!r1)
 		return;
 
 	dl_list_del(&r1->list);
-	eloop_cancel_timeout(wpa_ft_expire_pmk_r1, r1, NULL);
+	dl_list_del(&r1->hlist);
 
 	os_memset(r1->pmk_r1, 0, PMK_LEN_MAX);
 	os_free(r1->vlan);
@@ -1314,22 +1293,92 @@ static void wpa_ft_free_pmk_r1(struct wpa_ft_pmk_r1_sa *r1)
 }
 
 
-static void wpa_ft_expire_pmk_r1(void *eloop_ctx, void *timeout_ctx)
+/* Returns the next time the entry needs to be checked or 0 if it expired */
+static os_time_t wpa_ft_pmk_next_expiry(os_time_t now, os_time_t expiration,
+					os_time_t session_timeout,
+					os_time_t next)
+{
+	if ((expiration && expiration <= now) ||
+	    (session_timeout && session_timeout <= now))
+		return 0;
+	if (expiration && (!next || expiration < next))
+		next = expiration;
+	if (session_timeout && (!next || session_timeout < next))
+		next = session_timeout;
+	return next;
+}
+
+
+static void wpa_ft_pmk_cache_schedule(struct wpa_ft_pmk_cache *cache,
+				      os_time_t now, os_time_t expiry)
+{
+	unsigned int secs;
+
+	if (!expiry)
+		return;
+	secs = expiry > now ? expiry - now + 1 : 1;
+	if (eloop_deplete_timeout(secs, 0, wpa_ft_pmk_cache_expire,
+				  cache, NULL) < 0)
+		eloop_register_timeout(secs, 0, wpa_ft_pmk_cache_expire,
+				       cache, NULL);
+}
+
+
+/*
+ * A single timeout covers all entries in the cache. It is scheduled for the
+ * earliest expiration time and removes all entries that have expired by then.
+ */
+static void wpa_ft_pmk_cache_expire(void *eloop_ctx, void *timeout_ctx)
 {
-	struct wpa_ft_pmk_r1_sa *r1 = eloop_ctx;
+	struct wpa_ft_pmk_cache *cache = eloop_ctx;
+	struct wpa_ft_pmk_r0_sa *r0, *r0prev;
+	struct wpa_ft_pmk_r1_sa *r1, *r1prev;
+	struct os_reltime now;
+	os_time_t next = 0, expiry;
+
+	os_get_reltime(&now);
+
+	dl_list_for_each_safe(r0, r0prev, &cache->pmk_r0,
+			      struct wpa_ft_pmk_r0_sa, list) {
+		if (!r0->expiration && !r0->session_timeout)
+			continue;
+		expiry = wpa_ft_pmk_next_expiry(now.sec, r0->expiration,
+						r0->session_timeout, next);
+		if (expiry)
+			next = expiry;
+		else
+			wpa_ft_free_pmk_r0(r0);
+	}
+
+	dl_list_for_each_safe(r1, r1prev, &cache->pmk_r1,
+			      struct wpa_ft_pmk_r1_sa, list) {
+		if (!r1->expiration && !r1->session_timeout)
+			continue;
+		expiry = wpa_ft_pmk_next_expiry(now.sec, r1->expiration,
+						r1->session_timeout, next);
+		if (expiry)
+			next = expiry;
+		else
+			wpa_ft_free_pmk_r1(r1);
+	}
 
-	wpa_ft_free_pmk_r1(r1);
+	wpa_ft_pmk_cache_schedule(cache, now.sec, next);
 }
 
 
 struct wpa_ft_pmk_cache * wpa_ft_pmk_cache_init(void)
 {
 	struct wpa_ft_pmk_cache *cache;
+	int i;
 
 	cache = os_zalloc(sizeof(*cache));
 	if (cache) {
 		dl_list_init(&cache->pmk_r0);
 		dl_list_init(&cache->pmk_r1);
+		for (i = 0; i < FT_PMK_HASH_SIZE; i++) {
+			dl_list_init(&cache->pmk_r0_hash[i]);
+			dl_list_init(&cache->pmk_r1_hash[i]);
+		}
 	}
 
 	return cache;
@@ -1341,6 +1390,8 @@ void wpa_ft_pmk_cache_deinit(struct wpa_ft_pmk_cache *cache)
 	struct wpa_ft_pmk_r0_sa *r0, *r0prev;
 	struct wpa_ft_pmk_r1_sa *r1, *r1prev;
 
+	eloop_cancel_timeout(wpa_ft_pmk_cache_expire, cache, NULL);
+
 	dl_list_for_each_safe(r0, r0prev, &cache->pmk_r0,
 			      struct wpa_ft_pmk_r0_sa, list)
 		wpa_ft_free_pmk_r0(r0);
@@ -1353,6 +1404,42 @@ void wpa_ft_pmk_cache_deinit(struct wpa_ft_pmk_cache *cache)
 }
 
 
+int wpa_ft_pmk_cache_get_mib(struct wpa_ft_pmk_cache *cache, char *buf,
+			     size_t buflen)
+{
+	unsigned int avg = 0;
+	int ret;
+
+	if (!cache)
+		return 0;
+
+	if (cache->pmk_r1_pull_resps)
+		avg = cache->pmk_r1_pull_latency_total /
+			cache->pmk_r1_pull_resps;
+
+	ret = os_snprintf(buf, buflen,
+			  "hostapdFTPMKR0CacheEntries=%u\n"
+			  "hostapdFTPMKR0CacheHits=%u\n"
+			  "hostapdFTPMKR0CacheMisses=%u\n"
+			  "hostapdFTPMKR1CacheEntries=%u\n"
+			  "hostapdFTPMKR1CacheHits=%u\n"
+			  "hostapdFTPMKR1CacheMisses=%u\n"
+			  "hostapdFTPMKR1Pulls=%u\n"
+			  "hostapdFTPMKR1PullResponses=%u\n"
+			  "hostapdFTPMKR1PullLatencyAvg=%u\n"
+			  "hostapdFTPMKR1PullLatencyMax=%u\n",
+			  dl_list_len(&cache->pmk_r0),
+			  cache->pmk_r0_hits, cache->pmk_r0_misses,
+			  dl_list_len(&cache->pmk_r1),
+			  cache->pmk_r1_hits, cache->pmk_r1_misses,
+			  cache->pmk_r1_pulls, cache->pmk_r1_pull_resps,
+			  avg, cache->pmk_r1_pull_latency_max);
+	if (os_snprintf_error(buflen, ret))
+		return 0;
+	return ret;
+}
+
+
 static int wpa_ft_store_pmk_r0(struct wpa_authenticator *wpa_auth,
 			       const u8 *spa, const u8 *pmk_r0,
 			       size_t pmk_r0_len,
@@ -1406,12 +1493,12 @@ static int wpa_ft_store_pmk_r0(struct wpa_authenticator *wpa_auth,
 		r0->session_timeout = now.sec + session_timeout;
 
 	dl_list_add(&cache->pmk_r0, &r0->list);
-	if (expires_in > 0)
-		eloop_register_timeout(expires_in + 1, 0, wpa_ft_expire_pmk_r0,
-				       r0, NULL);
-	if (session_timeout > 0)
-		eloop_register_timeout(session_timeout + 1, 0,
-				       wpa_ft_expire_pmk_r0, r0, NULL);
+	dl_list_add(&cache->pmk_r0_hash[FT_PMK_HASH(spa)], &r0->hlist);
+	wpa_ft_pmk_cache_schedule(cache, now.sec,
+				  wpa_ft_pmk_next_expiry(now.sec,
+							 r0->expiration,
+							 r0->session_timeout,
+							 0));
 
 	return 0;
 }
@@ -1423,18 +1510,19 @@ static int wpa_ft_fetch_pmk_r0(struct wpa_authenticator *wpa_auth,
 {
 	struct wpa_ft_pmk_cache *cache = wpa_auth->ft_pmk_cache;
 	struct wpa_ft_pmk_r0_sa *r0;
-	struct os_reltime now;
 
-	os_get_reltime(&now);
-	dl_list_for_each(r0, &cache->pmk_r0, struct wpa_ft_pmk_r0_sa, list) {
+	dl_list_for_each(r0, &cache->pmk_r0_hash[FT_PMK_HASH(spa)],
+			 struct wpa_ft_pmk_r0_sa, hlist) {
 		if (ether_addr_equal(r0->spa, spa) &&
 		    os_memcmp_const(r0->pmk_r0_name, pmk_r0_name,
 				    WPA_PMK_NAME_LEN) == 0) {
+			cache->pmk_r0_hits++;
 			*r0_out = r0;
 			return 0;
 		}
 	}
 
+	cache->pmk_r0_misses++;
 	*r0_out = NULL;
 	return -1;
 }
@@ -1469,6 +1557,8 @@ static int wpa_ft_store_pmk_r1(struct wpa_authenticator *wpa_auth,
 	os_memcpy(r1->pmk_r1_name, pmk_r1_name, WPA_PMK_NAME_LEN);
 	os_memcpy(r1->spa, spa, ETH_ALEN);
 	r1->pairwise = pairwise;
+	if (expires_in > 0)
+		r1->expiration = now.sec + expires_in;
 	if (vlan && vlan->notempty) {
 		r1->vlan = os_zalloc(sizeof(*vlan));
 		if (!r1->vlan) {
@@ -1495,13 +1585,12 @@ static int wpa_ft_store_pmk_r1(struct wpa_authenticator *wpa_auth,
 		r1->session_timeout = now.sec + session_timeout;
 
 	dl_list_add(&cache->pmk_r1, &r1->list);
-
-	if (expires_in > 0)
-		eloop_register_timeout(expires_in + 1, 0, wpa_ft_expire_pmk_r1,
-				       r1, NULL);
-	if (session_timeout > 0)
-		eloop_register_timeout(session_timeout + 1, 0,
-				       wpa_ft_expire_pmk_r1, r1, NULL);
+	dl_list_add(&cache->pmk_r1_hash[FT_PMK_HASH(spa)], &r1->hlist);
+	wpa_ft_pmk_cache_schedule(cache, now.sec,
+				  wpa_ft_pmk_next_expiry(now.sec,
+							 r1->expiration,
+							 r1->session_timeout,
+							 0));
 
 	return 0;
 }
@@ -1521,10 +1610,12 @@ int wpa_ft_fetch_pmk_r1(struct wpa_authenticator *wpa_auth,
 
 	os_get_reltime(&now);
 
-	dl_list_for_each(r1, &cache->pmk_r1, struct wpa_ft_pmk_r1_sa, list) {
+	dl_list_for_each(r1, &cache->pmk_r1_hash[FT_PMK_HASH(spa)],
+			 struct wpa_ft_pmk_r1_sa, hlist) {
 		if (ether_addr_equal(r1->spa, spa) &&
 		    os_memcmp_const(r1->pmk_r1_name, pmk_r1_name,
 				    WPA_PMK_NAME_LEN) == 0) {
+			cache->pmk_r1_hits++;
 			os_memcpy(pmk_r1, r1->pmk_r1, r1->pmk_r1_len);
 			*pmk_r1_len = r1->pmk_r1_len;
 			if (pairwise)
@@ -1552,6 +1643,7 @@ int wpa_ft_fetch_pmk_r1(struct wpa_authenticator *wpa_auth,
 		}
 	}
 
+	cache->pmk_r1_misses++;
 	return -1;
 }
 
@@ -1573,6 +1665,95 @@ static int wpa_ft_rrb_init_r0kh_seq(struct ft_remote_r0kh *r0kh)
 }
 
 
+static unsigned int wpa_ft_r0kh_hash(const u8 *id, size_t id_len)
+{
+	unsigned int hash = 0;
+	size_t i;
+
+	for (i = 0; i < id_len; i++)
+		hash = hash * 31 + id[i];
+
+	return hash % FT_RKH_HASH_SIZE;
+}
+
+
+static unsigned int wpa_ft_r1kh_hash(const u8 *id)
+{
+	return (id[4] ^ id[5]) % FT_RKH_HASH_SIZE;
+}
+
+
+static bool wpa_ft_r0kh_is_wildcard(const struct ft_remote_r0kh *r0kh)
+{
+	return r0kh->id_len == 1 && r0kh->id[0] == '*';
+}
+
+
+static bool wpa_ft_r1kh_is_wildcard(const struct ft_remote_r1kh *r1kh)
+{
+	return is_zero_ether_addr(r1kh->addr) && is_zero_ether_addr(r1kh->id);
+}
+
+
+/*
+ * Index the R0KH/R1KH lists. The last matching list entry is the one that is
+ * used in case of duplicates, so the entries are added to the front of their
+ * hash chains in list order.
+ */
+static void wpa_ft_rkh_hash_build(struct wpa_authenticator *wpa_auth)
+{
+	struct ft_remote_r0kh *r0kh;
+	struct ft_remote_r1kh *r1kh;
+	unsigned int hash;
+
+	os_memset(wpa_auth->r0kh_hash, 0, sizeof(wpa_auth->r0kh_hash));
+	os_memset(wpa_auth->r1kh_hash, 0, sizeof(wpa_auth->r1kh_hash));
+	wpa_auth->r0kh_wildcard = NULL;
+	wpa_auth->r1kh_wildcard = NULL;
+
+	if (wpa_auth->conf.r0kh_list)
+		r0kh = *wpa_auth->conf.r0kh_list;
+	else
+		r0kh = NULL;
+	for (; r0kh; r0kh = r0kh->next) {
+		if (wpa_ft_r0kh_is_wildcard(r0kh))
+			wpa_auth->r0kh_wildcard = r0kh;
+		hash = wpa_ft_r0kh_hash(r0kh->id, r0kh->id_len);
+		r0kh->hnext = wpa_auth->r0kh_hash[hash];
+		wpa_auth->r0kh_hash[hash] = r0kh;
+	}
+
+	if (wpa_auth->conf.r1kh_list)
+		r1kh = *wpa_auth->conf.r1kh_list;
+	else
+		r1kh = NULL;
+	for (; r1kh; r1kh = r1kh->next) {
+		if (wpa_ft_r1kh_is_wildcard(r1kh))
+			wpa_auth->r1kh_wildcard = r1kh;
+		hash = wpa_ft_r1kh_hash(r1kh->id);
+		r1kh->hnext = wpa_auth->r1kh_hash[hash];
+		wpa_auth->r1kh_hash[hash] = r1kh;
+	}
+
+	wpa_auth->rkh_hash_valid = true;
+}
+
+
+/**
+ * wpa_ft_rkh_list_changed - Notify FT of modified R0KH/R1KH lists
+ * @wpa_auth: Pointer to WPA authenticator data from wpa_init()
+ *
+ * This needs to be called whenever entries are added to or removed from the
+ * r0kh_list/r1kh_list outside wpa_auth_ft.c, e.g., when reloading the RxKH
+ * configuration.
+ */
+void wpa_ft_rkh_list_changed(struct wpa_authenticator *wpa_auth)
+{
+	if (wpa_auth)
+		wpa_auth->rkh_hash_valid = false;
+}
+
+
 static void wpa_ft_rrb_lookup_r0kh(struct wpa_authenticator *wpa_auth,
 				   const u8 *f_r0kh_id, size_t f_r0kh_id_len,
 				   struct ft_remote_r0kh **r0kh_out,
@@ -1580,19 +1761,24 @@ static void wpa_ft_rrb_lookup_r0kh(struct wpa_authenticator *wpa_auth,
 {
 	struct ft_remote_r0kh *r0kh;
 
-	*r0kh_wildcard = NULL;
 	*r0kh_out = NULL;
 
-	if (wpa_auth->conf.r0kh_list)
-		r0kh = *wpa_auth->conf.r0kh_list;
+	if (!wpa_auth->rkh_hash_valid)
+		wpa_ft_rkh_hash_build(wpa_auth);
+
+	*r0kh_wildcard = wpa_auth->r0kh_wildcard;
+
+	if (f_r0kh_id)
+		r0kh = wpa_auth->r0kh_hash[wpa_ft_r0kh_hash(f_r0kh_id,
+							    f_r0kh_id_len)];
 	else
 		r0kh = NULL;
-	for (; r0kh; r0kh = r0kh->next) {
-		if (r0kh->id_len == 1 && r0kh->id[0] == '*')
-			*r0kh_wildcard = r0kh;
-		if (f_r0kh_id && r0kh->id_len == f_r0kh_id_len &&
-		    os_memcmp_const(f_r0kh_id, r0kh->id, f_r0kh_id_len) == 0)
+	for (; r0kh; r0kh = r0kh->hnext) {
+		if (r0kh->id_len == f_r0kh_id_len &&
+		    os_memcmp_const(f_r0kh_id, r0kh->id, f_r0kh_id_len) == 0) {
 			*r0kh_out = r0kh;
+			break;
+		}
 	}
 
 	if (!*r0kh_out && !*r0kh_wildcard)
@@ -1627,20 +1813,22 @@ static void wpa_ft_rrb_lookup_r1kh(struct wpa_authenticator *wpa_auth,
 {
 	struct ft_remote_r1kh *r1kh;
 
-	*r1kh_wildcard = NULL;
 	*r1kh_out = NULL;
 
-	if (wpa_auth->conf.r1kh_list)
-		r1kh = *wpa_auth->conf.r1kh_list;
+	if (!wpa_auth->rkh_hash_valid)
+		wpa_ft_rkh_hash_build(wpa_auth);
+
+	*r1kh_wildcard = wpa_auth->r1kh_wildcard;
+
+	if (f_r1kh_id)
+		r1kh = wpa_auth->r1kh_hash[wpa_ft_r1kh_hash(f_r1kh_id)];
 	else
 		r1kh = NULL;
-	for (; r1kh; r1kh = r1kh->next) {
-		if (is_zero_ether_addr(r1kh->addr) &&
-		    is_zero_ether_addr(r1kh->id))
-			*r1kh_wildcard = r1kh;
-		if (f_r1kh_id &&
-		    os_memcmp_const(r1kh->id, f_r1kh_id, FT_R1KH_ID_LEN) == 0)
+	for (; r1kh; r1kh = r1kh->hnext) {
+		if (os_memcmp_const(r1kh->id, f_r1kh_id, FT_R1KH_ID_LEN) == 0) {
 			*r1kh_out = r1kh;
+			break;
+		}
 	}
 
 	if (!*r1kh_out && !*r1kh_wildcard)
@@ -1674,6 +1862,74 @@ static int wpa_ft_rrb_check_r1kh(struct wpa_authenticator *wpa_auth,
 }
 
 
+static void wpa_ft_r0kh_hash_add(struct wpa_authenticator *wpa_auth,
+				 struct ft_remote_r0kh *r0kh)
+{
+	unsigned int hash;
+
+	if (!wpa_auth->rkh_hash_valid)
+		return; /* added when the index is rebuilt */
+	hash = wpa_ft_r0kh_hash(r0kh->id, r0kh->id_len);
+	r0kh->hnext = wpa_auth->r0kh_hash[hash];
+	wpa_auth->r0kh_hash[hash] = r0kh;
+	if (!wpa_auth->r0kh_wildcard && wpa_ft_r0kh_is_wildcard(r0kh))
+		wpa_auth->r0kh_wildcard = r0kh;
+}
+
+
+static void wpa_ft_r0kh_hash_del(struct wpa_authenticator *wpa_auth,
+				 struct ft_remote_r0kh *r0kh)
+{
+	struct ft_remote_r0kh **pos;
+
+	if (!wpa_auth->rkh_hash_valid)
+		return;
+	if (r0kh == wpa_auth->r0kh_wildcard) {
+		wpa_auth->rkh_hash_valid = false;
+		return;
+	}
+	pos = &wpa_auth->r0kh_hash[wpa_ft_r0kh_hash(r0kh->id, r0kh->id_len)];
+	while (*pos && *pos != r0kh)
+		pos = &(*pos)->hnext;
+	if (*pos)
+		*pos = r0kh->hnext;
+}
+
+
+static void wpa_ft_r1kh_hash_add(struct wpa_authenticator *wpa_auth,
+				 struct ft_remote_r1kh *r1kh)
+{
+	unsigned int hash;
+
+	if (!wpa_auth->rkh_hash_valid)
+		return; /* added when the index is rebuilt */
+	hash = wpa_ft_r1kh_hash(r1kh->id);
+	r1kh->hnext = wpa_auth->r1kh_hash[hash];
+	wpa_auth->r1kh_hash[hash] = r1kh;
+	if (!wpa_auth->r1kh_wildcard && wpa_ft_r1kh_is_wildcard(r1kh))
+		wpa_auth->r1kh_wildcard = r1kh;
+}
+
+
+static void wpa_ft_r1kh_hash_del(struct wpa_authenticator *wpa_auth,
+				 struct ft_remote_r1kh *r1kh)
+{
+	struct ft_remote_r1kh **pos;
+
+	if (!wpa_auth->rkh_hash_valid)
+		return;
+	if (r1kh == wpa_auth->r1kh_wildcard) {
+		wpa_auth->rkh_hash_valid = false;
+		return;
+	}
+	pos = &wpa_auth->r1kh_hash[wpa_ft_r1kh_hash(r1kh->id)];
+	while (*pos && *pos != r1kh)
+		pos = &(*pos)->hnext;
+	if (*pos)
+		*pos = r1kh->hnext;
+}
+
+
 static void wpa_ft_rrb_del_r0kh(void *eloop_ctx, void *timeout_ctx)
 {
 	struct wpa_authenticator *wpa_auth = eloop_ctx;
@@ -1693,6 +1949,7 @@ static void wpa_ft_rrb_del_r0kh(void *eloop_ctx, void *timeout_ctx)
 		prev->next = r0kh->next;
 	else
 		*wpa_auth->conf.r0kh_list = r0kh->next;
+	wpa_ft_r0kh_hash_del(wpa_auth, r0kh);
 	if (r0kh->seq)
 		wpa_ft_rrb_seq_flush(wpa_auth, r0kh->seq, 0);
 	os_free(r0kh->seq);
@@ -1747,6 +2004,7 @@ wpa_ft_rrb_add_r0kh(struct wpa_authenticator *wpa_auth,
 
 	r0kh->next = *wpa_auth->conf.r0kh_list;
 	*wpa_auth->conf.r0kh_list = r0kh;
+	wpa_ft_r0kh_hash_add(wpa_auth, r0kh);
 
 	if (timeout > 0)
 		eloop_register_timeout(timeout, 0, wpa_ft_rrb_del_r0kh,
@@ -1778,6 +2036,7 @@ static void wpa_ft_rrb_del_r1kh(void *eloop_ctx, void *timeout_ctx)
 		prev->next = r1kh->next;
 	else
 		*wpa_auth->conf.r1kh_list = r1kh->next;
+	wpa_ft_r1kh_hash_del(wpa_auth, r1kh);
 	if (r1kh->seq)
 		wpa_ft_rrb_seq_flush(wpa_auth, r1kh->seq, 0);
 	os_free(r1kh->seq);
@@ -1813,6 +2072,7 @@ wpa_ft_rrb_add_r1kh(struct wpa_authenticator *wpa_auth,
 	os_memcpy(r1kh->key, r1kh_wildcard->key, sizeof(r1kh->key));
 	r1kh->next = *wpa_auth->conf.r1kh_list;
 	*wpa_auth->conf.r1kh_list = r1kh;
+	wpa_ft_r1kh_hash_add(wpa_auth, r1kh);
 
 	if (timeout > 0)
 		eloop_register_timeout(timeout, 0, wpa_ft_rrb_del_r1kh,
@@ -1913,6 +2173,7 @@ void wpa_ft_deinit(struct wpa_authenticator *wpa_auth)
 {
 	wpa_ft_deinit_seq(wpa_auth);
 	wpa_ft_deinit_rkh_tmp(wpa_auth);
+	wpa_auth->rkh_hash_valid = false;
 }
 
 
@@ -2051,6 +2312,10 @@ static int wpa_ft_pull_pmk_r1(struct wpa_state_machine *sm,
 			   "nonce");
 		return -1;
 	}
+	if (first) {
+		os_get_reltime(&sm->ft_pending_pull_start);
+		sm->wpa_auth->ft_pmk_cache->pmk_r1_pulls++;
+	}
 
 	if (wpa_ft_new_seq(r0kh->seq, &f_seq) < 0) {
 		wpa_printf(MSG_DEBUG, "FT: Failed to get seq num");
@@ -4357,6 +4622,28 @@ static int ft_get_sta_cb(struct wpa_state_machine *sm, void *ctx)
 }
 
 
+static void wpa_ft_pull_latency_update(struct wpa_ft_pmk_cache *cache,
+				       struct wpa_state_machine *sm)
+{
+	struct os_reltime now, age;
+	unsigned int ms;
+
+	if (!os_reltime_initialized(&sm->ft_pending_pull_start))
+		return;
+	os_get_reltime(&now);
+	os_reltime_sub(&now, &sm->ft_pending_pull_start, &age);
+	os_memset(&sm->ft_pending_pull_start, 0,
+		  sizeof(sm->ft_pending_pull_start));
+	ms = age.sec * 1000 + age.usec / 1000;
+
+	wpa_printf(MSG_DEBUG, "FT: PMK-R1 pull completed in %u ms", ms);
+	cache->pmk_r1_pull_resps++;
+	cache->pmk_r1_pull_latency_total += ms;
+	if (ms > cache->pmk_r1_pull_latency_max)
+		cache->pmk_r1_pull_latency_max = ms;
+}
+
+
 static int wpa_ft_rrb_rx_resp(struct wpa_authenticator *wpa_auth,
 			      const u8 *src_addr,
 			      const u8 *enc, size_t enc_len,
@@ -4403,6 +4690,7 @@ static int wpa_ft_rrb_rx_resp(struct wpa_authenticator *wpa_auth,
 		eloop_cancel_timeout(wpa_ft_expire_pull, ctx.sm, NULL);
 		if (nak)
 			ctx.sm->ft_pending_pull_left_retries = 0;
+		wpa_ft_pull_latency_update(wpa_auth->ft_pmk_cache, ctx.sm);
 		ft_finish_pull(ctx.sm);
 	}
 
@@ -4956,7 +5244,8 @@ void wpa_ft_push_pmk_r1(struct wpa_authenticator *wpa_auth, const u8 *addr)
 	if (!wpa_auth->conf.r1kh_list)
 		return;
 
-	dl_list_for_each(r0, &cache->pmk_r0, struct wpa_ft_pmk_r0_sa, list) {
+	dl_list_for_each(r0, &cache->pmk_r0_hash[FT_PMK_HASH(addr)],
+			 struct wpa_ft_pmk_r0_sa, hlist) {
 		if (ether_addr_equal(r0->spa, addr)) {
 			r0found = r0;
 			break;
@@ -4981,4 +5270,89 @@ void wpa_ft_push_pmk_r1(struct wpa_authenticator *wpa_auth, const u8 *addr)
 	}
 }
 
+
+#ifdef CONFIG_MODULE_TESTS
+
+/*
+ * Verify that key holders added to the configured lists after the R0KH/R1KH
+ * index has been built are found once wpa_ft_rkh_list_changed() has been
+ * called, as done for SET r0kh/r1kh and RxKH reloads.
+ */
+int wpa_ft_rkh_module_tests(void)
+{
+	struct wpa_authenticator *wpa_auth;
+	struct ft_remote_r0kh *r0kh_list = NULL, *r0kh, *r0kh_wildcard;
+	struct ft_remote_r1kh *r1kh_list = NULL, *r1kh, *r1kh_wildcard;
+	struct ft_remote_r0kh r0kh_a, r0kh_b;
+	struct ft_remote_r1kh r1kh_a, r1kh_b;
+	int ret = -1;
+
+	wpa_printf(MSG_INFO, "FT R0KH/R1KH index tests");
+
+	wpa_auth = os_zalloc(sizeof(*wpa_auth));
+	if (!wpa_auth)
+		return -1;
+	wpa_auth->conf.r0kh_list = &r0kh_list;
+	wpa_auth->conf.r1kh_list = &r1kh_list;
+
+	os_memset(&r0kh_a, 0, sizeof(r0kh_a));
+	os_memset(&r0kh_b, 0, sizeof(r0kh_b));
+	os_memcpy(r0kh_a.id, "r0kh-a", 6);
+	r0kh_a.id_len = 6;
+	os_memcpy(r0kh_b.id, "r0kh-b", 6);
+	r0kh_b.id_len = 6;
+	os_memset(&r1kh_a, 0, sizeof(r1kh_a));
+	os_memset(&r1kh_b, 0, sizeof(r1kh_b));
+	r1kh_a.id[0] = r1kh_b.id[0] = 0x02;
+	r1kh_a.id[5] = 0x0a;
+	r1kh_b.id[5] = 0x0b;
+
+	r0kh_list = &r0kh_a;
+	r1kh_list = &r1kh_a;
+
+	/* The first lookups build the index */
+	wpa_ft_rrb_lookup_r0kh(wpa_auth, r0kh_a.id, r0kh_a.id_len,
+			       &r0kh, &r0kh_wildcard);
+	if (r0kh != &r0kh_a || !wpa_auth->rkh_hash_valid)
+		goto fail;
+	wpa_ft_rrb_lookup_r1kh(wpa_auth, r1kh_a.id, &r1kh, &r1kh_wildcard);
+	if (r1kh != &r1kh_a)
+		goto fail;
+
+	/* Add entries to the front of the lists like add_r0kh()/add_r1kh() */
+	r0kh_b.next = r0kh_list;
+	r0kh_list = &r0kh_b;
+	r1kh_b.next = r1kh_list;
+	r1kh_list = &r1kh_b;
+	wpa_ft_rkh_list_changed(wpa_auth);
+
+	wpa_ft_rrb_lookup_r0kh(wpa_auth, r0kh_b.id, r0kh_b.id_len,
+			       &r0kh, &r0kh_wildcard);
+	if (r0kh != &r0kh_b)
+		goto fail;
+	wpa_ft_rrb_lookup_r0kh(wpa_auth, r0kh_a.id, r0kh_a.id_len,
+			       &r0kh, &r0kh_wildcard);
+	if (r0kh != &r0kh_a)
+		goto fail;
+	wpa_ft_rrb_lookup_r1kh(wpa_auth, r1kh_b.id, &r1kh, &r1kh_wildcard);
+	if (r1kh != &r1kh_b)
+		goto fail;
+	wpa_ft_rrb_lookup_r1kh(wpa_auth, r1kh_a.id, &r1kh, &r1kh_wildcard);
+	if (r1kh != &r1kh_a)
+		goto fail;
+
+	ret = 0;
+fail:
+	if (ret)
+		wpa_printf(MSG_ERROR, "FT R0KH/R1KH index test failed");
+	os_free(r0kh_a.seq);
+	os_free(r0kh_b.seq);
+	os_free(r1kh_a.seq);
+	os_free(r1kh_b.seq);
+	os_free(wpa_auth);
+	return ret;
+}
+
+#endif /* CONFIG_MODULE_TESTS */
+
 #endif /* CONFIG_IEEE80211R_AP */
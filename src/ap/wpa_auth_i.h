@@ -14,6 +14,9 @@
 /* max(dot11RSNAConfigGroupUpdateCount,dot11RSNAConfigPairwiseUpdateCount) */
 #define RSNA_MAX_EAPOL_RETRIES 4
 
+/* Initial size of the per-STA EAPOL-Key TX buffer; grown on demand */
+#define WPA_AUTH_EAPOL_TX_BUF_LEN 512
+
 struct wpa_group;
 
 struct wpa_state_machine {
@@ -81,6 +84,9 @@ struct wpa_state_machine {
 	u8 *last_rx_eapol_key; /* starting from IEEE 802.1X header */
 	size_t last_rx_eapol_key_len;
 
+	u8 *eapol_tx_buf; /* reused for each EAPOL-Key frame to this STA */
+	size_t eapol_tx_buf_len;
+
 	unsigned int changed:1;
 	unsigned int in_step_loop:1;
 	unsigned int pending_deinit:1;
@@ -151,6 +157,7 @@ struct wpa_state_machine {
 	u8 ft_pending_auth_transaction;
 	u8 ft_pending_current_ap[ETH_ALEN];
 	int ft_pending_pull_left_retries;
+	struct os_reltime ft_pending_pull_start;
 #endif /* CONFIG_IEEE80211R_AP */
 
 	int pending_1_of_4_timeout;
@@ -234,6 +241,8 @@ struct wpa_group {
 
 struct wpa_ft_pmk_cache;
 
+#define FT_RKH_HASH_SIZE 256
+
 /* per authenticator data */
 struct wpa_authenticator {
 	struct wpa_group *group;
@@ -263,6 +272,16 @@ struct wpa_authenticator {
 
 	bool non_tx_beacon_prot;
 
+#ifdef CONFIG_IEEE80211R_AP
+	/* Hash indexes to conf.r0kh_list and conf.r1kh_list by key holder ID.
+	 * These are rebuilt on next use if rkh_hash_valid is cleared. */
+	struct ft_remote_r0kh *r0kh_hash[FT_RKH_HASH_SIZE];
+	struct ft_remote_r1kh *r1kh_hash[FT_RKH_HASH_SIZE];
+	struct ft_remote_r0kh *r0kh_wildcard;
+	struct ft_remote_r1kh *r1kh_wildcard;
+	bool rkh_hash_valid;
+#endif /* CONFIG_IEEE80211R_AP */
+
 #ifdef CONFIG_P2P
 	struct bitfield *ip_pool;
 #endif /* CONFIG_P2P */
@@ -348,6 +367,8 @@ void wpa_auth_ft_store_keys(struct wpa_state_machine *sm, const u8 *pmk_r0,
 			    size_t key_len);
 struct wpa_ft_pmk_cache * wpa_ft_pmk_cache_init(void);
 void wpa_ft_pmk_cache_deinit(struct wpa_ft_pmk_cache *cache);
+int wpa_ft_pmk_cache_get_mib(struct wpa_ft_pmk_cache *cache, char *buf,
+			     size_t buflen);
 void wpa_ft_install_ptk(struct wpa_state_machine *sm, int retry);
 int wpa_ft_store_pmk_fils(struct wpa_state_machine *sm, const u8 *pmk_r0,
 			  const u8 *pmk_r0_name);
@@ -17,6 +17,7 @@
 #include "gas.h"
 #include "wpa_common.h"
 #include "sae.h"
+#include "dpp.h"
 
 
 struct ieee802_11_parse_test_data {
@@ -792,5 +793,10 @@ int common_module_tests(void)
 	    rsn_ie_parse_tests() < 0)
 		ret = -1;
 
+#ifdef CONFIG_DPP
+	if (dpp_connector_cache_tests() < 0)
+		ret = -1;
+#endif /* CONFIG_DPP */
+
 	return ret;
 }
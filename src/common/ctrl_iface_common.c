@@ -115,25 +115,47 @@ void sockaddr_print(int level, const char *msg, struct sockaddr_storage *sock,
 
 static int ctrl_set_events(struct wpa_ctrl_dst *dst, const char *input)
 {
-	const char *value;
+	const char *pos, *end, *value;
+	size_t len;
 	int val;
 
 	if (!input)
 		return 0;
 
-	value = os_strchr(input, '=');
-	if (!value)
-		return -1;
-	value++;
-	val = atoi(value);
-	if (val < 0 || val > 1)
-		return -1;
+	/* Space separated list of <name>=<value> parameters */
+	for (pos = input; *pos; pos = end) {
+		while (*pos == ' ')
+			pos++;
+		if (!*pos)
+			break;
+		end = os_strchr(pos, ' ');
+		if (!end)
+			end = pos + os_strlen(pos);
+
+		value = os_strchr(pos, '=');
+		if (!value || value >= end)
+			return -1;
+		value++;
+
+		if (str_starts(pos, "filter=")) {
+			len = end - value;
+			if (len >= sizeof(dst->event_filter))
+				return -1;
+			os_memcpy(dst->event_filter, value, len);
+			dst->event_filter[len] = '\0';
+			continue;
+		}
+
+		val = atoi(value);
+		if (val < 0 || val > 1)
+			return -1;
 
-	if (str_starts(input, "probe_rx_events=")) {
-		if (val)
-			dst->events |= WPA_EVENT_RX_PROBE_REQUEST;
-		else
-			dst->events &= ~WPA_EVENT_RX_PROBE_REQUEST;
+		if (str_starts(pos, "probe_rx_events=")) {
+			if (val)
+				dst->events |= WPA_EVENT_RX_PROBE_REQUEST;
+			else
+				dst->events &= ~WPA_EVENT_RX_PROBE_REQUEST;
+		}
 	}
 
 	return 0;
@@ -145,11 +167,15 @@ int ctrl_iface_attach(struct dl_list *ctrl_dst, struct sockaddr_storage *from,
 {
 	struct wpa_ctrl_dst *dst;
 
-	/* Update event registration if already attached */
+	/* Update event registration if already attached. The event filter
+	 * applies only to the ATTACH command that set it, so a new ATTACH
+	 * without filter= goes back to all events. */
 	dl_list_for_each(dst, ctrl_dst, struct wpa_ctrl_dst, list) {
 		if (!sockaddr_compare(from, fromlen,
-				      &dst->addr, dst->addrlen))
+				      &dst->addr, dst->addrlen)) {
+			dst->event_filter[0] = '\0';
 			return ctrl_set_events(dst, input);
+		}
 	}
 
 	/* New attachment */
@@ -207,3 +233,57 @@ int ctrl_iface_level(struct dl_list *ctrl_dst, struct sockaddr_storage *from,
 
 	return -1;
 }
+
+
+/**
+ * ctrl_iface_event_wanted - Check whether a monitor wants an event message
+ * @dst: Control interface monitor
+ * @level: Priority level (MSG_*) of the message
+ * @txt: Event message
+ * @len: Length of the event message
+ * Returns: true if the message is to be sent to the monitor
+ */
+bool ctrl_iface_event_wanted(const struct wpa_ctrl_dst *dst, int level,
+			     const char *txt, size_t len)
+{
+	const char *pos, *end;
+	size_t flen;
+
+	if (level < dst->debug_level)
+		return false;
+	if (!dst->event_filter[0])
+		return true;
+
+	for (pos = dst->event_filter; *pos; pos = *end ? end + 1 : end) {
+		end = os_strchr(pos, ',');
+		if (!end)
+			end = pos + os_strlen(pos);
+		flen = end - pos;
+		if (flen && flen <= len && os_strncmp(txt, pos, flen) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+
+/**
+ * ctrl_iface_monitor_wanted - Check whether any monitor accepts a level
+ * @ctrl_dst: List of control interface monitors
+ * @level: Priority level (MSG_*) of the message
+ * Returns: true if at least one monitor accepts messages of the level
+ *
+ * This can be used to avoid formatting event messages that would not be sent
+ * to any monitor.
+ */
+bool ctrl_iface_monitor_wanted(struct dl_list *ctrl_dst, int level)
+{
+	struct wpa_ctrl_dst *dst;
+
+	dl_list_for_each(dst, ctrl_dst, struct wpa_ctrl_dst, list) {
+		if (level >= dst->debug_level)
+			return true;
+	}
+
+	return false;
+}
@@ -14,6 +14,9 @@
 /* Events enable bits (wpa_ctrl_dst::events) */
 #define WPA_EVENT_RX_PROBE_REQUEST BIT(0)
 
+/* Maximum length of the event filter (ATTACH filter=<list>) */
+#define WPA_CTRL_DST_FILTER_LEN 256
+
 /**
  * struct wpa_ctrl_dst - Data structure of control interface monitors
  *
@@ -27,6 +30,9 @@ struct wpa_ctrl_dst {
 	int debug_level;
 	int errors;
 	u32 events; /* WPA_EVENT_* bitmap */
+	/* Comma separated list of event name prefixes to deliver; empty string
+	 * means all events */
+	char event_filter[WPA_CTRL_DST_FILTER_LEN];
 };
 
 void sockaddr_print(int level, const char *msg, struct sockaddr_storage *sock,
@@ -38,5 +44,8 @@ int ctrl_iface_detach(struct dl_list *ctrl_dst, struct sockaddr_storage *from,
 		      socklen_t fromlen);
 int ctrl_iface_level(struct dl_list *ctrl_dst, struct sockaddr_storage *from,
 		     socklen_t fromlen, const char *level);
+bool ctrl_iface_event_wanted(const struct wpa_ctrl_dst *dst, int level,
+			     const char *txt, size_t len);
+bool ctrl_iface_monitor_wanted(struct dl_list *ctrl_dst, int level);
 
 #endif /* CONTROL_IFACE_COMMON_H */
@@ -4221,7 +4221,8 @@ struct json_token * dpp_parse_own_connector(const char *own_connector)
 
 
 enum dpp_status_error
-dpp_peer_intro(struct dpp_introduction *intro, const char *own_connector,
+dpp_peer_intro(struct dpp_global *dpp, struct dpp_introduction *intro,
+	       const char *own_connector,
 	       const u8 *net_access_key, size_t net_access_key_len,
 	       const u8 *csign_key, size_t csign_key_len,
 	       const u8 *peer_connector, size_t peer_connector_len,
@@ -4253,7 +4254,7 @@ dpp_peer_intro(struct dpp_introduction *intro, const char *own_connector,
 	if (!own_root)
 		goto fail;
 
-	res = dpp_check_signed_connector(&info, csign_key, csign_key_len,
+	res = dpp_check_signed_connector(dpp, &info, csign_key, csign_key_len,
 					 peer_connector, peer_connector_len);
 	if (res != DPP_STATUS_OK) {
 		ret = res;
@@ -5106,6 +5107,7 @@ void dpp_global_clear(struct dpp_global *dpp)
 
 	dpp_bootstrap_del(dpp, 0);
 	dpp_configurator_del(dpp, 0);
+	dpp_connector_cache_flush(dpp);
 #ifdef CONFIG_DPP2
 	dpp_tcp_init_flush(dpp);
 	dpp_relay_flush_controllers(dpp);
@@ -5266,3 +5268,123 @@ struct wpabuf * dpp_build_pb_announcement_resp(struct dpp_bootstrap_info *bi,
 }
 
 #endif /* CONFIG_DPP3 */
+
+
+#ifdef CONFIG_MODULE_TESTS
+
+static char * dpp_test_connector(struct dpp_configurator *conf,
+				 unsigned int group)
+{
+	struct wpabuf *dppcon;
+	char *signed_conn;
+
+	dppcon = wpabuf_alloc(100);
+	if (!dppcon)
+		return NULL;
+	wpabuf_printf(dppcon,
+		      "{\"groups\":[{\"groupId\":\"g%u\",\"netRole\":\"sta\"}]}",
+		      group);
+	signed_conn = dpp_sign_connector(conf, dppcon);
+	wpabuf_free(dppcon);
+	return signed_conn;
+}
+
+
+static enum dpp_status_error
+dpp_test_check_connector(struct dpp_global *dpp, const struct wpabuf *csign,
+			 const char *connector)
+{
+	struct dpp_signed_connector_info info;
+	enum dpp_status_error res;
+
+	os_memset(&info, 0, sizeof(info));
+	res = dpp_check_signed_connector(dpp, &info, wpabuf_head(csign),
+					 wpabuf_len(csign),
+					 (const u8 *) connector,
+					 os_strlen(connector));
+	os_free(info.payload);
+	return res;
+}
+
+
+int dpp_connector_cache_tests(void)
+{
+	struct dpp_global_config config;
+	struct dpp_global *dpp;
+	struct dpp_configurator *conf1, *conf2;
+	struct wpabuf *csign1 = NULL, *csign2 = NULL;
+	char *conn[DPP_CONNECTOR_CACHE_SIZE + 1];
+	unsigned int i, hits;
+	int id1, id2, ret = -1;
+
+	wpa_printf(MSG_INFO, "DPP connector cache tests");
+
+	os_memset(conn, 0, sizeof(conn));
+	os_memset(&config, 0, sizeof(config));
+	dpp = dpp_global_init(&config);
+	if (!dpp)
+		return -1;
+
+	id1 = dpp_configurator_add(dpp, "curve=prime256v1");
+	id2 = dpp_configurator_add(dpp, "curve=prime256v1");
+	conf1 = dpp_configurator_get_id(dpp, id1);
+	conf2 = dpp_configurator_get_id(dpp, id2);
+	if (!conf1 || !conf2)
+		goto fail;
+	csign1 = crypto_ec_key_get_subject_public_key(conf1->csign);
+	csign2 = crypto_ec_key_get_subject_public_key(conf2->csign);
+	if (!csign1 || !csign2)
+		goto fail;
+	for (i = 0; i <= DPP_CONNECTOR_CACHE_SIZE; i++) {
+		conn[i] = dpp_test_connector(conf1, i);
+		if (!conn[i])
+			goto fail;
+	}
+
+	/* The first verification is a miss and the second one a hit */
+	if (dpp_test_check_connector(dpp, csign1, conn[0]) != DPP_STATUS_OK ||
+	    dpp->conn_cache_hits != 0 || dpp->conn_cache_misses != 1 ||
+	    dpp_test_check_connector(dpp, csign1, conn[0]) != DPP_STATUS_OK ||
+	    dpp->conn_cache_hits != 1) {
+		wpa_printf(MSG_ERROR, "DPP: Connector cache hit not seen");
+		goto fail;
+	}
+
+	/* A changed C-sign-key does not use the cached entry */
+	if (dpp_test_check_connector(dpp, csign2, conn[0]) == DPP_STATUS_OK ||
+	    dpp->conn_cache_hits != 1) {
+		wpa_printf(MSG_ERROR,
+			   "DPP: Connector accepted with a changed C-sign-key");
+		goto fail;
+	}
+
+	/* Filling the cache evicts the least recently used entry */
+	for (i = 1; i <= DPP_CONNECTOR_CACHE_SIZE; i++) {
+		if (dpp_test_check_connector(dpp, csign1, conn[i]) !=
+		    DPP_STATUS_OK)
+			goto fail;
+	}
+	hits = dpp->conn_cache_hits;
+	if (dpp_test_check_connector(dpp, csign1,
+				     conn[DPP_CONNECTOR_CACHE_SIZE]) !=
+	    DPP_STATUS_OK ||
+	    dpp->conn_cache_hits != hits + 1 ||
+	    dpp_test_check_connector(dpp, csign1, conn[0]) != DPP_STATUS_OK ||
+	    dpp->conn_cache_hits != hits + 1) {
+		wpa_printf(MSG_ERROR, "DPP: Connector cache eviction failed");
+		goto fail;
+	}
+
+	ret = 0;
+fail:
+	for (i = 0; i <= DPP_CONNECTOR_CACHE_SIZE; i++)
+		os_free(conn[i]);
+	wpabuf_free(csign1);
+	wpabuf_free(csign2);
+	dpp_global_deinit(dpp);
+	if (ret)
+		wpa_printf(MSG_ERROR, "DPP connector cache test failure");
+	return ret;
+}
+
+#endif /* CONFIG_MODULE_TESTS */
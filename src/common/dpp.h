@@ -678,7 +678,8 @@ void dpp_configurator_free(struct dpp_configurator *conf);
 int dpp_configurator_own_config(struct dpp_authentication *auth,
 				const char *curve, int ap);
 enum dpp_status_error
-dpp_peer_intro(struct dpp_introduction *intro, const char *own_connector,
+dpp_peer_intro(struct dpp_global *dpp, struct dpp_introduction *intro,
+	       const char *own_connector,
 	       const u8 *net_access_key, size_t net_access_key_len,
 	       const u8 *csign_key, size_t csign_key_len,
 	       const u8 *peer_connector, size_t peer_connector_len,
@@ -834,6 +835,7 @@ struct dpp_global * dpp_global_init(struct dpp_global_config *config);
 void dpp_global_clear(struct dpp_global *dpp);
 void dpp_global_deinit(struct dpp_global *dpp);
 void dpp_notify_auth_success(struct dpp_authentication *auth, int initiator);
+int dpp_connector_cache_tests(void);
 
 /* dpp_reconfig.c */
 
@@ -852,14 +852,151 @@ fail:
 }
 
 
+static void dpp_connector_cache_entry_clear(
+	struct dpp_connector_cache_entry *e)
+{
+	bin_clear_free(e->payload, e->payload_len);
+	os_memset(e, 0, sizeof(*e));
+}
+
+
+void dpp_connector_cache_flush(struct dpp_global *dpp)
+{
+	unsigned int i;
+
+	for (i = 0; i < DPP_CONNECTOR_CACHE_SIZE; i++)
+		dpp_connector_cache_entry_clear(&dpp->conn_cache[i]);
+	if (dpp->conn_cache_hits || dpp->conn_cache_misses)
+		wpa_printf(MSG_DEBUG,
+			   "DPP: Connector verification cache flushed (hits=%u misses=%u)",
+			   dpp->conn_cache_hits,
+			   dpp->conn_cache_misses);
+	dpp->conn_cache_hits = dpp->conn_cache_misses = 0;
+	dpp->conn_cache_use = 0;
+}
+
+
+static int dpp_connector_cache_key(const u8 *csign_key, size_t csign_key_len,
+				   const u8 *connector, size_t connector_len,
+				   u8 *key)
+{
+	const u8 *addr[2];
+	size_t len[2];
+
+	addr[0] = csign_key;
+	len[0] = csign_key_len;
+	addr[1] = connector;
+	len[1] = connector_len;
+	return sha256_vector(2, addr, len, key);
+}
+
+
+static bool dpp_connector_cache_get(struct dpp_global *dpp, const u8 *key,
+				    struct dpp_signed_connector_info *info)
+{
+	struct dpp_connector_cache_entry *e;
+	struct os_time now;
+	unsigned int i;
+
+	for (i = 0; i < DPP_CONNECTOR_CACHE_SIZE; i++) {
+		e = &dpp->conn_cache[i];
+		if (!e->payload ||
+		    os_memcmp(e->key, key, SHA256_MAC_LEN) != 0)
+			continue;
+
+		if (e->expiry) {
+			os_get_time(&now);
+			if (now.sec >= e->expiry) {
+				wpa_printf(MSG_DEBUG,
+					   "DPP: Cached signedConnector has expired");
+				dpp_connector_cache_entry_clear(e);
+				return false;
+			}
+		}
+
+		info->payload = os_memdup(e->payload, e->payload_len);
+		if (!info->payload)
+			return false;
+		info->payload_len = e->payload_len;
+		e->last_used = ++dpp->conn_cache_use;
+		return true;
+	}
+
+	return false;
+}
+
+
+static void dpp_connector_cache_add(struct dpp_global *dpp, const u8 *key,
+				    const struct dpp_signed_connector_info *info)
+{
+	struct dpp_connector_cache_entry *e = NULL, *oldest = NULL;
+	struct json_token *root, *token;
+	os_time_t expiry = 0;
+	unsigned int i;
+
+	root = json_parse((const char *) info->payload, info->payload_len);
+	if (!root)
+		return;
+	token = json_get_member(root, "expiry");
+	if (token && token->type == JSON_STRING &&
+	    dpp_key_expired(token->string, &expiry)) {
+		/* The caller will reject this connector; do not cache it */
+		json_free(root);
+		return;
+	}
+	json_free(root);
+
+	for (i = 0; i < DPP_CONNECTOR_CACHE_SIZE; i++) {
+		e = &dpp->conn_cache[i];
+		if (!e->payload)
+			break;
+		if (!oldest || e->last_used < oldest->last_used)
+			oldest = e;
+		e = NULL;
+	}
+	if (!e) {
+		e = oldest;
+		dpp_connector_cache_entry_clear(e);
+	}
+
+	e->payload = os_memdup(info->payload, info->payload_len);
+	if (!e->payload)
+		return;
+	e->payload_len = info->payload_len;
+	os_memcpy(e->key, key, SHA256_MAC_LEN);
+	e->expiry = expiry;
+	e->last_used = ++dpp->conn_cache_use;
+}
+
+
 enum dpp_status_error
-dpp_check_signed_connector(struct dpp_signed_connector_info *info,
+dpp_check_signed_connector(struct dpp_global *dpp,
+			   struct dpp_signed_connector_info *info,
 			   const u8 *csign_key, size_t csign_key_len,
 			   const u8 *peer_connector, size_t peer_connector_len)
 {
-	struct crypto_ec_key *csign;
+	struct crypto_ec_key *csign = NULL;
 	char *signed_connector = NULL;
 	enum dpp_status_error res = DPP_STATUS_INVALID_CONNECTOR;
+	u8 cache_key[SHA256_MAC_LEN];
+	bool use_cache;
+
+	use_cache = dpp &&
+		dpp_connector_cache_key(csign_key, csign_key_len,
+					peer_connector, peer_connector_len,
+					cache_key) == 0;
+	if (use_cache) {
+		os_memset(info, 0, sizeof(*info));
+		if (dpp_connector_cache_get(dpp, cache_key, info)) {
+			dpp->conn_cache_hits++;
+			wpa_printf(MSG_DEBUG,
+				   "DPP: Peer signedConnector found in verification cache (hits=%u misses=%u)",
+				   dpp->conn_cache_hits,
+				   dpp->conn_cache_misses);
+			return DPP_STATUS_OK;
+		}
+		dpp->conn_cache_misses++;
+	}
 
 	csign = crypto_ec_key_parse_pub(csign_key, csign_key_len);
 	if (!csign) {
@@ -876,6 +1013,8 @@ dpp_check_signed_connector(struct dpp_signed_connector_info *info,
 	os_memcpy(signed_connector, peer_connector, peer_connector_len);
 	signed_connector[peer_connector_len] = '\0';
 	res = dpp_process_signed_connector(info, csign, signed_connector);
+	if (res == DPP_STATUS_OK && use_cache)
+		dpp_connector_cache_add(dpp, cache_key, info);
 fail:
 	os_free(signed_connector);
 	crypto_ec_key_deinit(csign);
@@ -13,10 +13,27 @@
 
 #ifdef CONFIG_DPP
 
+/* Successfully verified peer signedConnector so that repeated Network
+ * Introduction with the same peer does not need to redo the JWS signature
+ * verification. Entries are keyed by SHA-256(C-sign-key | signedConnector)
+ * and are dropped once the connector expires. */
+#define DPP_CONNECTOR_CACHE_SIZE 16
+
+struct dpp_connector_cache_entry {
+	u8 key[SHA256_MAC_LEN];
+	unsigned char *payload;
+	size_t payload_len;
+	os_time_t expiry; /* 0 = connector does not expire */
+	unsigned int last_used; /* dpp_global::conn_cache_use */
+};
+
 struct dpp_global {
 	void *msg_ctx;
 	struct dl_list bootstrap; /* struct dpp_bootstrap_info */
 	struct dl_list configurator; /* struct dpp_configurator */
+	struct dpp_connector_cache_entry conn_cache[DPP_CONNECTOR_CACHE_SIZE];
+	unsigned int conn_cache_use;
+	unsigned int conn_cache_hits, conn_cache_misses;
 #ifdef CONFIG_DPP2
 	struct dl_list controllers; /* struct dpp_relay_controller */
 	struct dpp_relay_controller *tmp_controller;
@@ -79,9 +96,11 @@ dpp_process_signed_connector(struct dpp_signed_connector_info *info,
 			     struct crypto_ec_key *csign_pub,
 			     const char *connector);
 enum dpp_status_error
-dpp_check_signed_connector(struct dpp_signed_connector_info *info,
+dpp_check_signed_connector(struct dpp_global *dpp,
+			   struct dpp_signed_connector_info *info,
 			   const u8 *csign_key, size_t csign_key_len,
 			   const u8 *peer_connector, size_t peer_connector_len);
+void dpp_connector_cache_flush(struct dpp_global *dpp);
 const struct dpp_curve_params * dpp_get_curve_name(const char *name);
 const struct dpp_curve_params * dpp_get_curve_jwk_crv(const char *name);
 const struct dpp_curve_params * dpp_get_curve_ike_group(u16 group);
@@ -487,7 +487,7 @@ dpp_reconfig_auth_req_rx(struct dpp_global *dpp, void *msg_ctx,
 	}
 	wpa_hexdump(MSG_DEBUG, "DPP: C-nonce", c_nonce, c_nonce_len);
 
-	res = dpp_check_signed_connector(&info, csign_key, csign_key_len,
+	res = dpp_check_signed_connector(dpp, &info, csign_key, csign_key_len,
 					 i_connector, i_connector_len);
 	if (res != DPP_STATUS_OK) {
 		wpa_printf(MSG_DEBUG, "DPP: Invalid I-Connector");
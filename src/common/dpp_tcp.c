@@ -20,6 +20,13 @@
 
 #ifdef CONFIG_DPP2
 
+/* Maximum number of concurrent connections from a Relay to a Controller */
+#define DPP_RELAY_MAX_CONN 15
+/* Maximum number of concurrent incoming connections to a local Controller */
+#define DPP_CONTROLLER_MAX_CONN 100
+/* Inactivity timeout (in seconds) for incoming TCP connections */
+#define DPP_TCP_CONN_IDLE_TIMEOUT 60
+
 struct dpp_connection {
 	struct dl_list list;
 	struct dpp_controller *ctrl;
@@ -97,6 +104,7 @@ static void dpp_tcp_build_new_key(void *eloop_ctx, void *timeout_ctx);
 #endif /* CONFIG_DPP3 */
 static void dpp_tcp_gas_query_comeback(void *eloop_ctx, void *timeout_ctx);
 static void dpp_relay_conn_timeout(void *eloop_ctx, void *timeout_ctx);
+static void dpp_tcp_conn_idle_timeout(void *eloop_ctx, void *timeout_ctx);
 
 
 static void dpp_connection_free(struct dpp_connection *conn)
@@ -113,6 +121,7 @@ static void dpp_connection_free(struct dpp_connection *conn)
 	eloop_cancel_timeout(dpp_tcp_build_csr, conn, NULL);
 	eloop_cancel_timeout(dpp_tcp_gas_query_comeback, conn, NULL);
 	eloop_cancel_timeout(dpp_relay_conn_timeout, conn, NULL);
+	eloop_cancel_timeout(dpp_tcp_conn_idle_timeout, conn, NULL);
 #ifdef CONFIG_DPP3
 	eloop_cancel_timeout(dpp_tcp_build_new_key, conn, NULL);
 #endif /* CONFIG_DPP3 */
@@ -445,6 +454,16 @@ static void dpp_relay_conn_timeout(void *eloop_ctx, void *timeout_ctx)
 }
 
 
+static void dpp_tcp_conn_idle_timeout(void *eloop_ctx, void *timeout_ctx)
+{
+	struct dpp_connection *conn = eloop_ctx;
+
+	wpa_printf(MSG_DEBUG,
+		   "DPP: Remove inactive TCP connection (sock %d)", conn->sock);
+	dpp_connection_remove(conn);
+}
+
+
 static struct dpp_connection *
 dpp_relay_new_conn(struct dpp_relay_controller *ctrl, const u8 *src,
 		   unsigned int freq)
@@ -454,7 +473,7 @@ dpp_relay_new_conn(struct dpp_relay_controller *ctrl, const u8 *src,
 	socklen_t addrlen;
 	char txt[100];
 
-	if (dl_list_len(&ctrl->conn) >= 15) {
+	if (dl_list_len(&ctrl->conn) >= DPP_RELAY_MAX_CONN) {
 		wpa_printf(MSG_DEBUG,
 			   "DPP: Too many ongoing Relay connections to the Controller - cannot start a new one");
 		return NULL;
@@ -1744,6 +1763,8 @@ static void dpp_controller_rx(int sd, void *eloop_ctx, void *sock_ctx)
 
 	wpa_printf(MSG_DEBUG, "DPP: TCP data available for reading (sock %d)",
 		   sd);
+	eloop_replenish_timeout(DPP_TCP_CONN_IDLE_TIMEOUT, 0,
+				dpp_tcp_conn_idle_timeout, conn, NULL);
 
 	if (conn->msg_len_octets < 4) {
 		u32 msglen;
@@ -1876,6 +1897,13 @@ static void dpp_controller_tcp_cb(int sd, void *eloop_ctx, void *sock_ctx)
 	wpa_printf(MSG_DEBUG, "DPP: Connection from %s:%d",
 		   inet_ntoa(addr.sin_addr), ntohs(addr.sin_port));
 
+	if (dl_list_len(&ctrl->conn) >= DPP_CONTROLLER_MAX_CONN) {
+		wpa_printf(MSG_DEBUG,
+			   "DPP: Too many ongoing connections to the Controller - reject new connection");
+		close(fd);
+		return;
+	}
+
 	conn = os_zalloc(sizeof(*conn));
 	if (!conn)
 		goto fail;
@@ -1900,8 +1928,8 @@ static void dpp_controller_tcp_cb(int sd, void *eloop_ctx, void *sock_ctx)
 		goto fail;
 	conn->read_eloop = 1;
 
-	/* TODO: eloop timeout to expire connections that do not complete in
-	 * reasonable time */
+	eloop_register_timeout(DPP_TCP_CONN_IDLE_TIMEOUT, 0,
+			       dpp_tcp_conn_idle_timeout, conn, NULL);
 	dl_list_add(&ctrl->conn, &conn->list);
 	return;
 
@@ -2471,7 +2499,7 @@ static void dpp_relay_tcp_cb(int sd, void *eloop_ctx, void *sock_ctx)
 		goto fail;
 	}
 
-	if (dl_list_len(&ctrl->conn) >= 15) {
+	if (dl_list_len(&ctrl->conn) >= DPP_RELAY_MAX_CONN) {
 		wpa_printf(MSG_DEBUG,
 			   "DPP: Too many ongoing Relay connections to the Controller - cannot start a new one");
 		goto fail;
@@ -2499,8 +2527,8 @@ static void dpp_relay_tcp_cb(int sd, void *eloop_ctx, void *sock_ctx)
 		goto fail;
 	conn->read_eloop = 1;
 
-	/* TODO: eloop timeout to expire connections that do not complete in
-	 * reasonable time */
+	eloop_register_timeout(DPP_TCP_CONN_IDLE_TIMEOUT, 0,
+			       dpp_tcp_conn_idle_timeout, conn, NULL);
 	dl_list_add(&ctrl->conn, &conn->list);
 	return;
 
@@ -64,6 +64,12 @@ enum nan_attr_id {
 #define NAN_SRV_CTRL_DISCOVERY_RANGE_LIMITED BIT(5)
 #define NAN_SRV_CTRL_BINDING_BITMAP BIT(6)
 
+/* Service Response Filter (SRF) Control field */
+#define NAN_SRF_CTRL_BF BIT(0)
+#define NAN_SRF_CTRL_INCLUDE BIT(1)
+#define NAN_SRF_CTRL_BF_IDX_MASK (BIT(2) | BIT(3))
+#define NAN_SRF_CTRL_BF_IDX_SHIFT 2
+
 enum nan_service_control_type {
 	NAN_SRV_CTRL_PUBLISH = 0,
 	NAN_SRV_CTRL_SUBSCRIBE = 1,
@@ -10,6 +10,7 @@
 
 #include "utils/common.h"
 #include "utils/eloop.h"
+#include "utils/crc32.h"
 #include "crypto/crypto.h"
 #include "crypto/sha256.h"
 #include "ieee802_11_defs.h"
@@ -64,8 +65,14 @@ struct nan_de_service {
 	struct os_reltime next_publish_chan;
 	unsigned int next_publish_duration;
 	bool is_p2p;
+
+	struct nan_de_service *hnext; /* next entry in hash table list */
 };
 
+#define NAN_DE_SRV_HASH_SIZE 16
+#define NAN_DE_SRV_HASH(id) ((id)[NAN_SERVICE_ID_LEN - 1] & \
+			     (NAN_DE_SRV_HASH_SIZE - 1))
+
 struct nan_de {
 	u8 nmi[ETH_ALEN];
 	bool offload;
@@ -75,6 +82,8 @@ struct nan_de {
 
 	struct nan_de_service *service[NAN_DE_MAX_SERVICE];
 	unsigned int num_service;
+	/* Service ID hash table for RX SDF processing */
+	struct nan_de_service *srv_hash[NAN_DE_SRV_HASH_SIZE];
 
 	int next_handle;
 
@@ -161,6 +170,7 @@ void nan_de_flush(struct nan_de *de)
 		de->service[i] = NULL;
 	}
 
+	os_memset(de->srv_hash, 0, sizeof(de->srv_hash));
 	de->num_service = 0;
 	nan_de_clear_pending(de);
 }
@@ -388,6 +398,31 @@ static void nan_de_tx_multicast(struct nan_de *de, struct nan_de_service *srv,
 }
 
 
+static void nan_de_srv_hash_add(struct nan_de *de,
+				struct nan_de_service *srv)
+{
+	unsigned int h = NAN_DE_SRV_HASH(srv->service_id);
+
+	srv->hnext = de->srv_hash[h];
+	de->srv_hash[h] = srv;
+}
+
+
+static void nan_de_srv_hash_del(struct nan_de *de,
+				struct nan_de_service *srv)
+{
+	struct nan_de_service **pos;
+
+	for (pos = &de->srv_hash[NAN_DE_SRV_HASH(srv->service_id)]; *pos;
+	     pos = &(*pos)->hnext) {
+		if (*pos == srv) {
+			*pos = srv->hnext;
+			break;
+		}
+	}
+}
+
+
 static void nan_de_add_srv(struct nan_de *de, struct nan_de_service *srv)
 {
 	int ttl;
@@ -402,6 +437,7 @@ static void nan_de_add_srv(struct nan_de *de, struct nan_de_service *srv)
 
 	de->service[srv->id - 1] = srv;
 	de->num_service++;
+	nan_de_srv_hash_add(de, srv);
 }
 
 
@@ -409,6 +445,7 @@ static void nan_de_del_srv(struct nan_de *de, struct nan_de_service *srv,
 			   enum nan_de_reason reason)
 {
 	de->service[srv->id - 1] = NULL;
+	nan_de_srv_hash_del(de, srv);
 	nan_de_service_deinit(de, srv, reason);
 	de->num_service--;
 	if (de->num_service == 0)
@@ -946,11 +983,66 @@ static bool nan_de_filter_match(struct nan_de_service *srv,
 }
 
 
+static bool nan_de_bloom_filter_match(const u8 *bf, size_t bf_len, u8 idx,
+				      const u8 *addr)
+{
+	u8 data[1 + ETH_ALEN];
+	unsigned int j, bit, m = bf_len * 8;
+
+	/* H(j, X, m) = (CRC32(A(j) || X) & 0x0000FFFF) mod m with
+	 * A(j) = 4 * Bloom Filter Index + j, j = 0..3 */
+	os_memcpy(&data[1], addr, ETH_ALEN);
+	for (j = 0; j < 4; j++) {
+		data[0] = idx * 4 + j;
+		bit = (ieee80211_crc32(data, sizeof(data)) & 0xffff) % m;
+		if (!(bf[bit / 8] & BIT(bit % 8)))
+			return false;
+	}
+
+	return true;
+}
+
+
+static bool nan_de_srf_match(struct nan_de *de, const u8 *srf, size_t srf_len)
+{
+	u8 ctrl;
+	bool found = false;
+
+	if (!srf || srf_len < 1)
+		return true;
+
+	ctrl = *srf++;
+	srf_len--;
+
+	if (ctrl & NAN_SRF_CTRL_BF) {
+		if (srf_len == 0)
+			return false;
+		found = nan_de_bloom_filter_match(
+			srf, srf_len,
+			(ctrl & NAN_SRF_CTRL_BF_IDX_MASK) >>
+			NAN_SRF_CTRL_BF_IDX_SHIFT,
+			de->nmi);
+	} else {
+		while (srf_len >= ETH_ALEN) {
+			if (ether_addr_equal(srf, de->nmi)) {
+				found = true;
+				break;
+			}
+			srf += ETH_ALEN;
+			srf_len -= ETH_ALEN;
+		}
+	}
+
+	return !!(ctrl & NAN_SRF_CTRL_INCLUDE) == found;
+}
+
+
 static void nan_de_rx_subscribe(struct nan_de *de, struct nan_de_service *srv,
 				const u8 *peer_addr, const u8 *a3,
 				u8 instance_id,
 				const u8 *matching_filter,
 				size_t matching_filter_len,
+				const u8 *srf, size_t srf_len,
 				enum nan_service_protocol_type srv_proto_type,
 				const u8 *ssi, size_t ssi_len)
 {
@@ -965,6 +1057,12 @@ static void nan_de_rx_subscribe(struct nan_de *de, struct nan_de_service *srv,
 	if (!nan_de_filter_match(srv, matching_filter, matching_filter_len))
 		return;
 
+	if (!nan_de_srf_match(de, srf, srf_len)) {
+		wpa_printf(MSG_DEBUG,
+			   "NAN: Service Response Filter does not match own NMI - ignore Subscribe message");
+		return;
+	}
+
 	if (!srv->publish.solicited)
 		return;
 
@@ -1096,7 +1194,6 @@ static void nan_de_rx_sda(struct nan_de *de, const u8 *peer_addr, const u8 *a3,
 	const u8 *service_id;
 	u8 instance_id, req_instance_id, ctrl;
 	u16 sdea_control = 0;
-	unsigned int i;
 	enum nan_service_control_type type = 0;
 	enum nan_service_protocol_type srv_proto_type = 0;
 	const u8 *ssi = NULL;
@@ -1105,6 +1202,9 @@ static void nan_de_rx_sda(struct nan_de *de, const u8 *peer_addr, const u8 *a3,
 	const u8 *end;
 	const u8 *matching_filter = NULL;
 	size_t matching_filter_len = 0;
+	const u8 *srf = NULL;
+	size_t srf_len = 0;
+	struct nan_de_service *srv;
 
 	if (sda_len < NAN_SERVICE_ID_LEN + 1 + 1 + 1)
 		return;
@@ -1156,6 +1256,8 @@ static void nan_de_rx_sda(struct nan_de *de, const u8 *peer_addr, const u8 *a3,
 		flen = *sda++;
 		if (end - sda < flen)
 			return;
+		srf = sda;
+		srf_len = flen;
 		sda += flen;
 	}
 
@@ -1178,11 +1280,8 @@ static void nan_de_rx_sda(struct nan_de *de, const u8 *peer_addr, const u8 *a3,
 		sda += flen;
 	}
 
-	for (i = 0; i < NAN_DE_MAX_SERVICE; i++) {
-		struct nan_de_service *srv = de->service[i];
-
-		if (!srv)
-			continue;
+	for (srv = de->srv_hash[NAN_DE_SRV_HASH(service_id)]; srv;
+	     srv = srv->hnext) {
 		if (os_memcmp(srv->service_id, service_id,
 			      NAN_SERVICE_ID_LEN) != 0)
 			continue;
@@ -1195,8 +1294,8 @@ static void nan_de_rx_sda(struct nan_de *de, const u8 *peer_addr, const u8 *a3,
 		if (type == NAN_SRV_CTRL_SUBSCRIBE &&
 		    srv->type == NAN_DE_SUBSCRIBE)
 			continue;
-		wpa_printf(MSG_DEBUG, "NAN: Received SDF matches service ID %u",
-			   i + 1);
+		wpa_printf(MSG_DEBUG, "NAN: Received SDF matches service ID %d",
+			   srv->id);
 
 		if (first) {
 			first = false;
@@ -1225,6 +1324,7 @@ static void nan_de_rx_sda(struct nan_de *de, const u8 *peer_addr, const u8 *a3,
 			nan_de_rx_subscribe(de, srv, peer_addr, a3, instance_id,
 					    matching_filter,
 					    matching_filter_len,
+					    srf, srf_len,
 					    srv_proto_type,
 					    ssi, ssi_len);
 			break;
@@ -499,6 +499,11 @@ extern "C" {
 #define WPA_BSS_MASK_ML			BIT(26)
 #define WPA_BSS_MASK_AP_MLD_ADDR	BIT(27)
 
+/* Reply buffer size used for bulk dump commands (BSS_DUMP, STA-DUMP,
+ * LOG_RING). Clients using these commands need to be prepared to receive
+ * replies of this size. */
+#define WPA_CTRL_BULK_REPLY_SIZE 32768
+
 
 /* VENDOR_ELEM_* frame id values */
 enum wpa_vendor_elem_frame {
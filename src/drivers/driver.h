@@ -3837,6 +3837,33 @@ struct wpa_driver_ops {
 			       size_t data_len, int encrypt,
 			       const u8 *own_addr, u32 flags, int link_id);
 
+	/**
+	 * hapd_send_eapol_vector - Send an EAPOL packet from a vector (AP only)
+	 * @priv: private driver interface data
+	 * @addr: Destination MAC address
+	 * @num_elem: Number of elements in the data vector
+	 * @elem: Pointers to the data areas, the first one starting with
+	 *	IEEE 802.1X header
+	 * @elem_len: Lengths of the data areas in octets
+	 * @encrypt: Whether the frame should be encrypted
+	 * @own_addr: Source MAC address
+	 * @flags: WPA_STA_* flags for the destination station
+	 * @link_id: Link ID to use for TX, or -1 if not set
+	 *
+	 * Returns: 0 on success, -1 on failure
+	 *
+	 * This is an optional variant of hapd_send_eapol() that allows the
+	 * caller to pass the IEEE 802.1X header and the payload as separate
+	 * buffers without first concatenating them. Drivers that do not
+	 * implement this get a single contiguous buffer through
+	 * hapd_send_eapol() instead.
+	 */
+	int (*hapd_send_eapol_vector)(void *priv, const u8 *addr,
+				      size_t num_elem, const u8 *elem[],
+				      const size_t *elem_len, int encrypt,
+				      const u8 *own_addr, u32 flags,
+				      int link_id);
+
 	/**
 	 * sta_deauth - Deauthenticate a station (AP only)
 	 * @priv: Private driver interface data
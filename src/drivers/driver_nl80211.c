@@ -267,6 +267,87 @@ struct i802_bss * get_bss_ifindex(struct wpa_driver_nl80211_data *drv,
 }
 
 
+void nl80211_bss_hash_del(struct i802_bss *bss)
+{
+	struct nl80211_global *global = bss->drv->global;
+	struct i802_bss **pos;
+	unsigned int i;
+
+	for (i = 0; i < NL80211_BSS_HASH_SIZE; i++) {
+		for (pos = &global->ifindex_hash[i]; *pos;
+		     pos = &(*pos)->ifindex_hnext) {
+			if (*pos == bss) {
+				*pos = bss->ifindex_hnext;
+				break;
+			}
+		}
+		for (pos = &global->wdev_hash[i]; *pos;
+		     pos = &(*pos)->wdev_hnext) {
+			if (*pos == bss) {
+				*pos = bss->wdev_hnext;
+				break;
+			}
+		}
+	}
+	bss->ifindex_hnext = NULL;
+	bss->wdev_hnext = NULL;
+}
+
+
+void nl80211_bss_hash_add(struct i802_bss *bss)
+{
+	struct nl80211_global *global = bss->drv->global;
+	unsigned int h;
+
+	nl80211_bss_hash_del(bss);
+
+	if (bss->ifindex > 0) {
+		h = NL80211_BSS_HASH(bss->ifindex);
+		bss->ifindex_hnext = global->ifindex_hash[h];
+		global->ifindex_hash[h] = bss;
+	}
+
+	if (bss->wdev_id_set) {
+		h = NL80211_BSS_HASH(bss->wdev_id);
+		bss->wdev_hnext = global->wdev_hash[h];
+		global->wdev_hash[h] = bss;
+	}
+}
+
+
+/**
+ * nl80211_bss_hash_get - Find the BSS for a global event
+ * @global: nl80211 global data
+ * @ifindex: ifindex from the event or -1 if not included
+ * @wdev_id: wdev_id from the event or %NULL if not included
+ * Returns: Pointer to the BSS or %NULL if not found
+ *
+ * Only BSSs of driver interfaces that are in the global interface list are
+ * returned so that the result matches iteration over global->interfaces.
+ */
+struct i802_bss * nl80211_bss_hash_get(struct nl80211_global *global,
+				       int ifindex, const u64 *wdev_id)
+{
+	struct i802_bss *bss;
+
+	if (ifindex > 0) {
+		bss = global->ifindex_hash[NL80211_BSS_HASH(ifindex)];
+		for (; bss; bss = bss->ifindex_hnext) {
+			if (bss->ifindex == ifindex)
+				return bss->drv->in_interface_list ? bss : NULL;
+		}
+	} else if (wdev_id) {
+		bss = global->wdev_hash[NL80211_BSS_HASH(*wdev_id)];
+		for (; bss; bss = bss->wdev_hnext) {
+			if (bss->wdev_id_set && bss->wdev_id == *wdev_id)
+				return bss->drv->in_interface_list ? bss : NULL;
+		}
+	}
+
+	return NULL;
+}
+
+
 static int is_mesh_interface(enum nl80211_iftype nlmode)
 {
 	return nlmode == NL80211_IFTYPE_MESH_POINT;
@@ -1861,19 +1942,160 @@ static int nl80211_channel_info(void *priv, struct wpa_channel_info *ci)
 }
 
 
-static void wpa_driver_nl80211_event_receive(int sock, void *eloop_ctx,
-					     void *handle)
+/* Maximum number of event messages processed per eloop wakeup on the global
+ * event socket; a larger limit is used after the socket has overrun */
+#define NL80211_EVENT_BATCH_MAX 64
+#define NL80211_EVENT_DRAIN_MAX 1024
+
+static void nl80211_rx_overrun(struct nl80211_global *global, int fd,
+			       struct nl80211_rx_stats *stats, const char *dbg)
 {
-	struct nl_cb *cb = eloop_ctx;
-	int res;
+	int cur, size;
+	socklen_t optlen = sizeof(cur);
 
-	wpa_printf(MSG_MSGDUMP, "nl80211: Event message available");
+	stats->overruns++;
+	wpa_printf(MSG_INFO,
+		   "nl80211: %s socket receive buffer overrun - events were lost (overruns=%u)",
+		   dbg, stats->overruns);
+
+	/* Linux reports twice the requested size for SO_RCVBUF */
+	if (getsockopt(fd, SOL_SOCKET, SO_RCVBUF, &cur, &optlen) < 0)
+		return;
+	size = cur > global->rx_buf_max ? global->rx_buf_max : cur;
+	if (size <= cur / 2)
+		return;
 
+	/* SO_RCVBUFFORCE allows exceeding rmem_max with CAP_NET_ADMIN */
+	if (setsockopt(fd, SOL_SOCKET, SO_RCVBUFFORCE, &size,
+		       sizeof(size)) < 0 &&
+	    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size)) < 0) {
+		wpa_printf(MSG_DEBUG,
+			   "nl80211: Could not grow %s socket RX buffer: %s",
+			   dbg, strerror(errno));
+		return;
+	}
+	stats->rx_buf = size;
+	wpa_printf(MSG_DEBUG, "nl80211: Increased %s socket RX buffer to %d",
+		   dbg, size);
+}
+
+
+/*
+ * Receive and process pending event messages from a socket. Returns 1 if the
+ * socket receive buffer overran, 0 otherwise.
+ *
+ * The event handlers may free the BSS that owns the handle and stats, so
+ * neither is accessed after nl_recvmsgs() returns.
+ */
+static int nl80211_recv_event(struct nl_sock *handle, struct nl_cb *cb,
+			      struct nl80211_rx_stats *stats, const char *dbg)
+{
+	int res, err;
+
+	stats->msgs++;
+	errno = 0;
 	res = nl_recvmsgs(handle, cb);
-	if (res < 0) {
+	err = errno;
+	if (res >= 0)
+		return 0;
+
+	/* libnl reports both ENOBUFS from recvmsg() and memory allocation
+	 * failures as -NLE_NOMEM; only the former means that events were
+	 * lost. */
+	if (res == -NLE_NOMEM && err == ENOBUFS)
+		return 1;
+
+	if (res == -NLE_NOMEM)
+		wpa_printf(MSG_INFO,
+			   "nl80211: %s->nl_recvmsgs failed: %d (%s)",
+			   dbg, res, strerror(err));
+	else
 		wpa_printf(MSG_INFO, "nl80211: %s->nl_recvmsgs failed: %d",
-			   __func__, res);
+			   dbg, res);
+	return 0;
+}
+
+
+static bool nl80211_bss_in_global(struct nl80211_global *global,
+				  struct i802_bss *bss)
+{
+	struct wpa_driver_nl80211_data *drv;
+	struct i802_bss *tmp;
+
+	/* Compare pointers only; bss may have been freed */
+	dl_list_for_each(drv, &global->interfaces,
+			 struct wpa_driver_nl80211_data, list) {
+		for (tmp = drv->first_bss; tmp; tmp = tmp->next) {
+			if (tmp == bss)
+				return true;
+		}
+	}
+
+	return false;
+}
+
+
+static void wpa_driver_nl80211_global_event_receive(int sock, void *eloop_ctx,
+						    void *handle)
+{
+	struct nl80211_global *global = eloop_ctx;
+	struct nl80211_rx_stats *stats = &global->event_stats;
+	unsigned int count = 0;
+	bool overrun = false;
+	u8 peek;
+	int res;
+
+	wpa_printf(MSG_MSGDUMP, "nl80211: Event message available");
+	stats->wakeups++;
+
+	/*
+	 * Drain the messages that are already queued instead of returning to
+	 * eloop for each of them. After an overrun, keep reading until the
+	 * queue is empty to resynchronize with the kernel as quickly as
+	 * possible.
+	 */
+	for (;;) {
+		if (nl80211_recv_event(handle, global->nl_cb, stats,
+				       "event")) {
+			nl80211_rx_overrun(global, sock, stats, "event");
+			overrun = true;
+		}
+		count++;
+		if (count >= (overrun ? NL80211_EVENT_DRAIN_MAX :
+			      NL80211_EVENT_BATCH_MAX))
+			break;
+
+		res = recv(sock, &peek, sizeof(peek), MSG_PEEK | MSG_DONTWAIT);
+		if (res < 0 && errno == ENOBUFS) {
+			/* The pending error was consumed by recv() */
+			nl80211_rx_overrun(global, sock, stats, "event");
+			overrun = true;
+			continue;
+		}
+		if (res <= 0)
+			break;
 	}
+
+	if (count > stats->max_batch)
+		stats->max_batch = count;
+}
+
+
+static void wpa_driver_nl80211_event_receive(int sock, void *eloop_ctx,
+					     void *handle)
+{
+	struct i802_bss *bss = eloop_ctx;
+	struct nl80211_global *global = bss->drv->global;
+
+	wpa_printf(MSG_MSGDUMP, "nl80211: Event message available");
+
+	if (!nl80211_recv_event(handle, bss->nl_cb, &bss->rx_stats, "bss"))
+		return;
+
+	/* The BSS may have been removed by the event handlers */
+	if (!nl80211_bss_in_global(global, bss))
+		return;
+	nl80211_rx_overrun(global, sock, &bss->rx_stats, "bss");
 }
 
 
@@ -2064,8 +2286,8 @@ static int wpa_driver_nl80211_init_nl_global(struct nl80211_global *global)
 		  process_global_event, global);
 
 	nl80211_register_eloop_read(&global->nl_event,
-				    wpa_driver_nl80211_event_receive,
-				    global->nl_cb, 0);
+				    wpa_driver_nl80211_global_event_receive,
+				    global, 0);
 
 	return 0;
 
@@ -2217,7 +2439,7 @@ static int nl80211_init_connect_handle(struct i802_bss *bss)
 		return -1;
 	nl80211_register_eloop_read(&bss->nl_connect,
 				    wpa_driver_nl80211_event_receive,
-				    bss->nl_cb, 1);
+				    bss, 1);
 	return 0;
 }
 
@@ -2241,6 +2463,7 @@ static int nl80211_init_bss(struct i802_bss *bss)
 
 static void nl80211_destroy_bss(struct i802_bss *bss)
 {
+	nl80211_bss_hash_del(bss);
 	nl_cb_put(bss->nl_cb);
 	bss->nl_cb = NULL;
 
@@ -2497,7 +2720,7 @@ static void nl80211_mgmt_handle_register_eloop(struct i802_bss *bss)
 {
 	nl80211_register_eloop_read(&bss->nl_mgmt,
 				    wpa_driver_nl80211_event_receive,
-				    bss->nl_cb, 0);
+				    bss, 0);
 }
 
 
@@ -3066,6 +3289,7 @@ wpa_driver_nl80211_finish_drv_init(struct wpa_driver_nl80211_data *drv,
 	bss->ifindex = drv->ifindex;
 	bss->wdev_id = drv->global->if_add_wdevid;
 	bss->wdev_id_set = drv->global->if_add_wdevid_set;
+	nl80211_bss_hash_add(bss);
 
 	bss->if_dynamic = drv->ifindex == drv->global->if_add_ifindex;
 	bss->if_dynamic = bss->if_dynamic || drv->global->if_add_wdevid_set;
@@ -3220,6 +3444,7 @@ static void wpa_driver_nl80211_del_beacon_all(struct i802_bss *bss)
 static void wpa_driver_nl80211_deinit(struct i802_bss *bss)
 {
 	struct wpa_driver_nl80211_data *drv = bss->drv;
+	struct i802_bss *tbss;
 	unsigned int i;
 
 	wpa_printf(MSG_INFO, "nl80211: deinit ifname=%s disabled_11b_rates=%d",
@@ -3305,6 +3530,10 @@ static void wpa_driver_nl80211_deinit(struct i802_bss *bss)
 		nl80211_del_p2pdev(bss);
 	}
 
+	/* Make sure no BSS of this driver instance remains reachable from the
+	 * global event routing tables */
+	for (tbss = drv->first_bss->next; tbss; tbss = tbss->next)
+		nl80211_bss_hash_del(tbss);
 	nl80211_destroy_bss(drv->first_bss);
 
 	os_free(drv->filter_ssids);
@@ -6436,16 +6665,23 @@ static void nl80211_teardown_ap(struct i802_bss *bss)
 }
 
 
-static int nl80211_tx_control_port(void *priv, const u8 *dest,
-				   u16 proto, const u8 *buf, size_t len,
-				   int no_encrypt, int link_id)
+static int nl80211_tx_control_port_vector(struct i802_bss *bss,
+					  const u8 *dest, u16 proto,
+					  size_t num_elem, const u8 *elem[],
+					  const size_t *elem_len,
+					  int no_encrypt, int link_id)
 {
 	struct nl80211_ack_ext_arg ext_arg;
-	struct i802_bss *bss = priv;
 	struct nl_msg *msg;
+	struct nlattr *frame;
 	u64 cookie = 0;
+	size_t i, len = 0;
+	u8 *pos;
 	int ret;
 
+	for (i = 0; i < num_elem; i++)
+		len += elem_len[i];
+
 	wpa_printf(MSG_DEBUG,
 		   "nl80211: Send over control port dest=" MACSTR
 		   " proto=0x%04x len=%u no_encrypt=%d",
@@ -6455,7 +6691,7 @@ static int nl80211_tx_control_port(void *priv, const u8 *dest,
 	if (!msg ||
 	    nla_put_u16(msg, NL80211_ATTR_CONTROL_PORT_ETHERTYPE, proto) ||
 	    nla_put(msg, NL80211_ATTR_MAC, ETH_ALEN, dest) ||
-	    nla_put(msg, NL80211_ATTR_FRAME, len, buf) ||
+	    !(frame = nla_reserve(msg, NL80211_ATTR_FRAME, len)) ||
 	    (no_encrypt &&
 	     nla_put_flag(msg, NL80211_ATTR_CONTROL_PORT_NO_ENCRYPT)) ||
 	    (link_id != NL80211_DRV_LINK_ID_NA &&
@@ -6464,6 +6700,13 @@ static int nl80211_tx_control_port(void *priv, const u8 *dest,
 		return -ENOBUFS;
 	}
 
+	/* Gather the frame directly into the netlink message */
+	pos = nla_data(frame);
+	for (i = 0; i < num_elem; i++) {
+		os_memcpy(pos, elem[i], elem_len[i]);
+		pos += elem_len[i];
+	}
+
 	os_memset(&ext_arg, 0, sizeof(struct nl80211_ack_ext_arg));
 	ext_arg.ext_data = &cookie;
 	ret = send_and_recv(bss->drv, bss->drv->global->nl, msg,
@@ -6486,11 +6729,23 @@ static int nl80211_tx_control_port(void *priv, const u8 *dest,
 }
 
 
-static int nl80211_send_eapol_data(struct i802_bss *bss,
-				   const u8 *addr, const u8 *data,
-				   size_t data_len)
+static int nl80211_tx_control_port(void *priv, const u8 *dest,
+				   u16 proto, const u8 *buf, size_t len,
+				   int no_encrypt, int link_id)
+{
+	return nl80211_tx_control_port_vector(priv, dest, proto, 1, &buf,
+					      &len, no_encrypt, link_id);
+}
+
+
+static int nl80211_send_eapol_data(struct i802_bss *bss, const u8 *addr,
+				   size_t num_elem, const u8 *elem[],
+				   const size_t *elem_len)
 {
 	struct sockaddr_ll ll;
+	struct iovec iov[4];
+	struct msghdr msg;
+	size_t i;
 	int ret;
 
 	if (bss->drv->eapol_tx_sock < 0) {
@@ -6498,14 +6753,26 @@ static int nl80211_send_eapol_data(struct i802_bss *bss,
 		return -1;
 	}
 
+	if (num_elem > ARRAY_SIZE(iov))
+		return -1;
+	for (i = 0; i < num_elem; i++) {
+		iov[i].iov_base = (void *) elem[i];
+		iov[i].iov_len = elem_len[i];
+	}
+
 	os_memset(&ll, 0, sizeof(ll));
 	ll.sll_family = AF_PACKET;
 	ll.sll_ifindex = bss->ifindex;
 	ll.sll_protocol = htons(ETH_P_PAE);
 	ll.sll_halen = ETH_ALEN;
 	os_memcpy(ll.sll_addr, addr, ETH_ALEN);
-	ret = sendto(bss->drv->eapol_tx_sock, data, data_len, 0,
-		     (struct sockaddr *) &ll, sizeof(ll));
+
+	os_memset(&msg, 0, sizeof(msg));
+	msg.msg_name = &ll;
+	msg.msg_namelen = sizeof(ll);
+	msg.msg_iov = iov;
+	msg.msg_iovlen = num_elem;
+	ret = sendmsg(bss->drv->eapol_tx_sock, &msg, 0);
 	if (ret < 0)
 		wpa_printf(MSG_ERROR, "nl80211: EAPOL TX: %s",
 			   strerror(errno));
@@ -6514,9 +6781,9 @@ static int nl80211_send_eapol_data(struct i802_bss *bss,
 }
 
 
-static int wpa_driver_nl80211_hapd_send_eapol(
-	void *priv, const u8 *addr, const u8 *data,
-	size_t data_len, int encrypt, const u8 *own_addr, u32 flags,
+static int wpa_driver_nl80211_hapd_send_eapol_vector(
+	void *priv, const u8 *addr, size_t num_elem, const u8 *elem[],
+	const size_t *elem_len, int encrypt, const u8 *own_addr, u32 flags,
 	int link_id)
 {
 	struct i802_bss *bss = priv;
@@ -6526,11 +6793,24 @@ static int wpa_driver_nl80211_hapd_send_eapol(
 	 * since it does not provide TX status notifications. */
 	if (drv->control_port_ap &&
 	    (drv->capa.flags & WPA_DRIVER_FLAGS_CONTROL_PORT))
-		return nl80211_tx_control_port(bss, addr, ETH_P_EAPOL,
-					       data, data_len, !encrypt,
-					       link_id);
+		return nl80211_tx_control_port_vector(bss, addr, ETH_P_EAPOL,
+						      num_elem, elem,
+						      elem_len, !encrypt,
+						      link_id);
 
-	return nl80211_send_eapol_data(bss, addr, data, data_len);
+	return nl80211_send_eapol_data(bss, addr, num_elem, elem, elem_len);
+}
+
+
+static int wpa_driver_nl80211_hapd_send_eapol(
+	void *priv, const u8 *addr, const u8 *data,
+	size_t data_len, int encrypt, const u8 *own_addr, u32 flags,
+	int link_id)
+{
+	return wpa_driver_nl80211_hapd_send_eapol_vector(priv, addr, 1, &data,
+							 &data_len, encrypt,
+							 own_addr, flags,
+							 link_id);
 }
 
 
@@ -9223,6 +9503,7 @@ static int wpa_driver_nl80211_if_add(void *priv, enum wpa_driver_if_type type,
 		if (drv_priv)
 			*drv_priv = new_bss;
 		nl80211_init_bss(new_bss);
+		nl80211_bss_hash_add(new_bss);
 
 		/* Set interface mode to NL80211_IFTYPE_AP */
 		if (nl80211_set_mode(new_bss, nlmode))
@@ -9694,7 +9975,7 @@ static int wpa_driver_nl80211_probe_req_report(struct i802_bss *bss, int report)
 
 	nl80211_register_eloop_read(&bss->nl_preq,
 				    wpa_driver_nl80211_event_receive,
-				    bss->nl_cb, 0);
+				    bss, 0);
 
 	return 0;
 
@@ -10242,6 +10523,15 @@ static int nl80211_set_param(void *priv, const char *param)
 	if (os_strstr(param, "rsn_override_in_driver=1"))
 		drv->capa.flags2 |= WPA_DRIVER_FLAGS2_RSN_OVERRIDE_STA;
 
+	pos = os_strstr(param, "nl_rx_buf_max=");
+	if (pos) {
+		int val = atoi(pos + 14);
+
+		if (val <= 0)
+			return -EINVAL;
+		drv->global->rx_buf_max = val;
+	}
+
 	pos = os_strstr(param, "extra_bss_membership_selectors=");
 	if (pos) {
 		int i = 0;
@@ -10292,6 +10582,7 @@ static void * nl80211_global_init(void *ctx)
 	global->ioctl_sock = -1;
 	dl_list_init(&global->interfaces);
 	global->if_add_ifindex = -1;
+	global->rx_buf_max = NL80211_RX_BUF_MAX_DEFAULT;
 
 	cfg = os_zalloc(sizeof(*cfg));
 	if (cfg == NULL)
@@ -11407,6 +11698,31 @@ static int wpa_driver_nl80211_status(void *priv, char *buf, size_t buflen)
 		pos += res;
 	}
 
+	res = os_snprintf(pos, end - pos,
+			  "nl_event_wakeups=%u\n"
+			  "nl_event_msgs=%u\n"
+			  "nl_event_max_batch=%u\n"
+			  "nl_event_overruns=%u\n"
+			  "nl_event_rx_buf=%d\n"
+			  "nl_bss_msgs=%u\n"
+			  "nl_bss_overruns=%u\n"
+			  "nl_bss_rx_buf=%d\n"
+			  "nl_event_route_hash=%u\n"
+			  "nl_event_route_walk=%u\n",
+			  drv->global->event_stats.wakeups,
+			  drv->global->event_stats.msgs,
+			  drv->global->event_stats.max_batch,
+			  drv->global->event_stats.overruns,
+			  drv->global->event_stats.rx_buf,
+			  bss->rx_stats.msgs,
+			  bss->rx_stats.overruns,
+			  bss->rx_stats.rx_buf,
+			  drv->global->event_route_hash,
+			  drv->global->event_route_walk);
+	if (os_snprintf_error(end - pos, res))
+		return pos - buf;
+	pos += res;
+
 	res = os_snprintf(pos, end - pos,
 			  "phyname=%s\n"
 			  "perm_addr=" MACSTR "\n"
@@ -15003,6 +15319,7 @@ const struct wpa_driver_ops wpa_driver_nl80211_ops = {
 	.sta_remove = driver_nl80211_sta_remove,
 	.tx_control_port = nl80211_tx_control_port,
 	.hapd_send_eapol = wpa_driver_nl80211_hapd_send_eapol,
+	.hapd_send_eapol_vector = wpa_driver_nl80211_hapd_send_eapol_vector,
 	.sta_set_flags = wpa_driver_nl80211_sta_set_flags,
 	.sta_set_airtime_weight = driver_nl80211_sta_set_airtime_weight,
 	.hapd_init = i802_init,
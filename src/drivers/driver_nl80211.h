@@ -22,6 +22,21 @@
 	nla_nest_start(msg, NLA_F_NESTED | (attrtype))
 #endif
 
+/* Default upper limit for growing netlink socket receive buffers after an
+ * overrun; can be changed with the nl_rx_buf_max=<bytes> driver parameter */
+#define NL80211_RX_BUF_MAX_DEFAULT (4 * 1024 * 1024)
+
+struct nl80211_rx_stats {
+	unsigned int wakeups; /* number of times the socket was readable */
+	unsigned int msgs; /* number of received netlink messages */
+	unsigned int max_batch; /* maximum number of messages per wakeup */
+	unsigned int overruns; /* receive buffer overruns (ENOBUFS) */
+	int rx_buf; /* receive buffer size after last growth or 0 */
+};
+
+#define NL80211_BSS_HASH_SIZE 64
+#define NL80211_BSS_HASH(idx) ((unsigned int) (idx) % NL80211_BSS_HASH_SIZE)
+
 struct nl80211_global {
 	void *ctx;
 	struct dl_list interfaces;
@@ -36,6 +51,13 @@ struct nl80211_global {
 	int nlctrl_id;
 	int ioctl_sock; /* socket for ioctl() use */
 	struct nl_sock *nl_event;
+	struct nl80211_rx_stats event_stats;
+	int rx_buf_max;
+	/* Global event routing by ifindex and wdev_id */
+	struct i802_bss *ifindex_hash[NL80211_BSS_HASH_SIZE];
+	struct i802_bss *wdev_hash[NL80211_BSS_HASH_SIZE];
+	unsigned int event_route_hash; /* events routed with the hash tables */
+	unsigned int event_route_walk; /* events routed by list iteration */
 	u8 p2p_perm_addr[ETH_ALEN];
 };
 
@@ -93,6 +115,9 @@ struct i802_bss {
 	void *ctx;
 	struct nl_sock *nl_preq, *nl_mgmt, *nl_connect;
 	struct nl_cb *nl_cb;
+	struct nl80211_rx_stats rx_stats;
+	struct i802_bss *ifindex_hnext; /* next entry in ifindex hash list */
+	struct i802_bss *wdev_hnext; /* next entry in wdev_id hash list */
 
 	struct nl80211_wiphy_data *wiphy_data;
 	struct dl_list wiphy_list;
@@ -362,6 +387,10 @@ int nl80211_get_link_signal(struct wpa_driver_nl80211_data *drv,
 int nl80211_get_link_noise(struct wpa_driver_nl80211_data *drv,
 			   struct wpa_signal_info *sig_change);
 int nl80211_get_wiphy_index(struct i802_bss *bss);
+void nl80211_bss_hash_add(struct i802_bss *bss);
+void nl80211_bss_hash_del(struct i802_bss *bss);
+struct i802_bss * nl80211_bss_hash_get(struct nl80211_global *global,
+				       int ifindex, const u64 *wdev_id);
 int wpa_driver_nl80211_set_mode(struct i802_bss *bss,
 				enum nl80211_iftype nlmode);
 int wpa_driver_nl80211_mlme(struct wpa_driver_nl80211_data *drv,
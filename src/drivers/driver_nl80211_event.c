@@ -4356,6 +4356,20 @@ int process_global_event(struct nl_msg *msg, void *arg)
 		wiphy_idx_set = 1;
 	}
 
+	/* Events directed to a specific interface or wdev are delivered to a
+	 * single BSS, so look it up directly instead of iterating over all
+	 * interfaces. */
+	if (ifidx != -1 || wdev_id_set) {
+		bss = nl80211_bss_hash_get(global, ifidx,
+					   wdev_id_set ? &wdev_id : NULL);
+		if (bss) {
+			global->event_route_hash++;
+			do_process_drv_event(bss, gnlh->cmd, tb);
+			return NL_SKIP;
+		}
+	}
+	global->event_route_walk++;
+
 	dl_list_for_each_safe(drv, tmp, &global->interfaces,
 			      struct wpa_driver_nl80211_data, list) {
 		unsigned int unique_drv_id = drv->unique_drv_id;
@@ -8,7 +8,13 @@
 
 #include "includes.h"
 #include <sys/ioctl.h>
+#ifdef CONFIG_L2_PACKET_RING
+/* TPACKET_V3 definitions are not included in netpacket/packet.h */
+#include <linux/if_packet.h>
+#include <sys/mman.h>
+#else /* CONFIG_L2_PACKET_RING */
 #include <netpacket/packet.h>
+#endif /* CONFIG_L2_PACKET_RING */
 #include <net/if.h>
 #include <linux/filter.h>
 
@@ -38,8 +44,27 @@ struct l2_packet_data {
 	u8 last_hash_prev[SHA1_MAC_LEN];
 	unsigned int num_rx_br;
 #endif /* CONFIG_NO_LINUX_PACKET_SOCKET_WAR */
+
+#ifdef CONFIG_L2_PACKET_RING
+	/* TPACKET_V3 RX ring mapped from the main packet socket */
+	u8 *ring;
+	size_t ring_len;
+	unsigned int ring_block; /* next block to process */
+	unsigned int ring_rx:1; /* RX callback running from ring processing */
+	unsigned int ring_deinit:1; /* deinit requested during ring_rx */
+#endif /* CONFIG_L2_PACKET_RING */
 };
 
+#ifdef CONFIG_L2_PACKET_RING
+/* EAPOL and other L2 control frames are small and infrequent enough for a
+ * 256 kB ring. Blocks are retired to user space after one millisecond even if
+ * not full to keep the added RX latency negligible. */
+#define L2_RING_BLOCK_SIZE 32768
+#define L2_RING_BLOCK_NR 8
+#define L2_RING_FRAME_SIZE 2048
+#define L2_RING_BLOCK_TOV_MS 1
+#endif /* CONFIG_L2_PACKET_RING */
+
 /* Generated by 'sudo tcpdump -s 3000 -dd greater 278 and ip and udp and
  * src port bootps and dst port bootpc'
  */
@@ -145,26 +170,11 @@ int l2_packet_send(struct l2_packet_data *l2, const u8 *dst_addr, u16 proto,
 }
 
 
-static void l2_packet_receive(int sock, void *eloop_ctx, void *sock_ctx)
+static void l2_packet_rx(struct l2_packet_data *l2, const u8 *src_addr,
+			 const u8 *buf, size_t res)
 {
-	struct l2_packet_data *l2 = eloop_ctx;
-	u8 buf[2300];
-	int res;
-	struct sockaddr_ll ll;
-	socklen_t fromlen;
-
-	os_memset(&ll, 0, sizeof(ll));
-	fromlen = sizeof(ll);
-	res = recvfrom(sock, buf, sizeof(buf), 0, (struct sockaddr *) &ll,
-		       &fromlen);
-	if (res < 0) {
-		wpa_printf(MSG_DEBUG, "l2_packet_receive - recvfrom: %s",
-			   strerror(errno));
-		return;
-	}
-
-	wpa_printf(MSG_DEBUG, "%s: src=" MACSTR " len=%d",
-		   __func__, MAC2STR(ll.sll_addr), (int) res);
+	wpa_printf(MSG_DEBUG, "l2_packet_receive: src=" MACSTR " len=%d",
+		   MAC2STR(src_addr), (int) res);
 
 #ifndef CONFIG_NO_LINUX_PACKET_SOCKET_WAR
 	if (l2->fd_br_rx >= 0) {
@@ -211,10 +221,144 @@ static void l2_packet_receive(int sock, void *eloop_ctx, void *sock_ctx)
 
 	l2->last_from_br = 0;
 #endif /* CONFIG_NO_LINUX_PACKET_SOCKET_WAR */
-	l2->rx_callback(l2->rx_callback_ctx, ll.sll_addr, buf, res);
+	l2->rx_callback(l2->rx_callback_ctx, src_addr, buf, res);
+}
+
+
+static void l2_packet_receive(int sock, void *eloop_ctx, void *sock_ctx)
+{
+	struct l2_packet_data *l2 = eloop_ctx;
+	u8 buf[2300];
+	int res;
+	struct sockaddr_ll ll;
+	socklen_t fromlen;
+
+	os_memset(&ll, 0, sizeof(ll));
+	fromlen = sizeof(ll);
+	res = recvfrom(sock, buf, sizeof(buf), 0, (struct sockaddr *) &ll,
+		       &fromlen);
+	if (res < 0) {
+		wpa_printf(MSG_DEBUG, "l2_packet_receive - recvfrom: %s",
+			   strerror(errno));
+		return;
+	}
+
+	l2_packet_rx(l2, ll.sll_addr, buf, res);
+}
+
+
+#ifdef CONFIG_L2_PACKET_RING
+
+static void l2_packet_free(struct l2_packet_data *l2);
+
+
+static void l2_packet_receive_ring(int sock, void *eloop_ctx, void *sock_ctx)
+{
+	struct l2_packet_data *l2 = eloop_ctx;
+	struct tpacket_block_desc *bd;
+	struct tpacket3_hdr *hdr;
+	const struct sockaddr_ll *ll;
+	unsigned int blocks, i;
+
+	/*
+	 * Process all blocks that the kernel has retired to user space. The
+	 * RX callback may deinit the l2_packet instance, so the actual free
+	 * is postponed until the end of the batch.
+	 */
+	l2->ring_rx = 1;
+	for (blocks = 0; blocks < L2_RING_BLOCK_NR; blocks++) {
+		bd = (struct tpacket_block_desc *)
+			(l2->ring + l2->ring_block * L2_RING_BLOCK_SIZE);
+		if (!(__atomic_load_n(&bd->hdr.bh1.block_status,
+				      __ATOMIC_ACQUIRE) & TP_STATUS_USER))
+			break;
+
+		hdr = (struct tpacket3_hdr *)
+			((u8 *) bd + bd->hdr.bh1.offset_to_first_pkt);
+		for (i = 0; i < bd->hdr.bh1.num_pkts && !l2->ring_deinit; i++) {
+			ll = (const struct sockaddr_ll *)
+				((u8 *) hdr +
+				 TPACKET_ALIGN(sizeof(struct tpacket3_hdr)));
+			l2_packet_rx(l2, ll->sll_addr,
+				     (const u8 *) hdr + hdr->tp_mac,
+				     hdr->tp_snaplen);
+			hdr = (struct tpacket3_hdr *)
+				((u8 *) hdr + hdr->tp_next_offset);
+		}
+
+		__atomic_store_n(&bd->hdr.bh1.block_status, TP_STATUS_KERNEL,
+				 __ATOMIC_RELEASE);
+		l2->ring_block = (l2->ring_block + 1) % L2_RING_BLOCK_NR;
+		if (l2->ring_deinit)
+			break;
+	}
+	l2->ring_rx = 0;
+
+	if (l2->ring_deinit)
+		l2_packet_free(l2);
 }
 
 
+static int l2_packet_init_ring(struct l2_packet_data *l2)
+{
+	int ver = TPACKET_V3;
+	struct tpacket_req3 req;
+
+	if (setsockopt(l2->fd, SOL_PACKET, PACKET_VERSION, &ver,
+		       sizeof(ver)) < 0) {
+		wpa_printf(MSG_DEBUG,
+			   "l2_packet_linux: setsockopt(PACKET_VERSION) failed: %s",
+			   strerror(errno));
+		return -1;
+	}
+
+	os_memset(&req, 0, sizeof(req));
+	req.tp_block_size = L2_RING_BLOCK_SIZE;
+	req.tp_block_nr = L2_RING_BLOCK_NR;
+	req.tp_frame_size = L2_RING_FRAME_SIZE;
+	req.tp_frame_nr = L2_RING_BLOCK_SIZE / L2_RING_FRAME_SIZE *
+		L2_RING_BLOCK_NR;
+	req.tp_retire_blk_tov = L2_RING_BLOCK_TOV_MS;
+	if (setsockopt(l2->fd, SOL_PACKET, PACKET_RX_RING, &req,
+		       sizeof(req)) < 0) {
+		wpa_printf(MSG_DEBUG,
+			   "l2_packet_linux: setsockopt(PACKET_RX_RING) failed: %s",
+			   strerror(errno));
+		goto fail;
+	}
+
+	l2->ring_len = (size_t) L2_RING_BLOCK_SIZE * L2_RING_BLOCK_NR;
+	l2->ring = mmap(NULL, l2->ring_len, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_LOCKED, l2->fd, 0);
+	if (l2->ring == MAP_FAILED) {
+		/* MAP_LOCKED may fail due to RLIMIT_MEMLOCK */
+		l2->ring = mmap(NULL, l2->ring_len, PROT_READ | PROT_WRITE,
+				MAP_SHARED, l2->fd, 0);
+	}
+	if (l2->ring == MAP_FAILED) {
+		wpa_printf(MSG_DEBUG,
+			   "l2_packet_linux: mmap(RX ring) failed: %s",
+			   strerror(errno));
+		l2->ring = NULL;
+		os_memset(&req, 0, sizeof(req));
+		setsockopt(l2->fd, SOL_PACKET, PACKET_RX_RING, &req,
+			   sizeof(req));
+		goto fail;
+	}
+
+	wpa_printf(MSG_DEBUG, "l2_packet_linux: Using TPACKET_V3 RX ring for %s",
+		   l2->ifname);
+	return 0;
+
+fail:
+	ver = TPACKET_V1;
+	setsockopt(l2->fd, SOL_PACKET, PACKET_VERSION, &ver, sizeof(ver));
+	return -1;
+}
+
+#endif /* CONFIG_L2_PACKET_RING */
+
+
 #ifndef CONFIG_NO_LINUX_PACKET_SOCKET_WAR
 static void l2_packet_receive_br(int sock, void *eloop_ctx, void *sock_ctx)
 {
@@ -330,6 +474,14 @@ struct l2_packet_data * l2_packet_init(
 	}
 	os_memcpy(l2->own_addr, ifr.ifr_hwaddr.sa_data, ETH_ALEN);
 
+#ifdef CONFIG_L2_PACKET_RING
+	if (rx_callback && l2_packet_init_ring(l2) == 0) {
+		eloop_register_read_sock(l2->fd, l2_packet_receive_ring, l2,
+					 NULL);
+		return l2;
+	}
+#endif /* CONFIG_L2_PACKET_RING */
+
 	if (rx_callback)
 		eloop_register_read_sock(l2->fd, l2_packet_receive, l2, NULL);
 
@@ -422,13 +574,14 @@ struct l2_packet_data * l2_packet_init_bridge(
 }
 
 
-void l2_packet_deinit(struct l2_packet_data *l2)
+static void l2_packet_free(struct l2_packet_data *l2)
 {
-	if (l2 == NULL)
-		return;
-
 	if (l2->fd >= 0) {
 		eloop_unregister_read_sock(l2->fd);
+#ifdef CONFIG_L2_PACKET_RING
+		if (l2->ring)
+			munmap(l2->ring, l2->ring_len);
+#endif /* CONFIG_L2_PACKET_RING */
 		close(l2->fd);
 	}
 
@@ -443,6 +596,24 @@ void l2_packet_deinit(struct l2_packet_data *l2)
 }
 
 
+void l2_packet_deinit(struct l2_packet_data *l2)
+{
+	if (l2 == NULL)
+		return;
+
+#ifdef CONFIG_L2_PACKET_RING
+	if (l2->ring_rx) {
+		/* Called from the RX callback; the ring is still being
+		 * processed, so free at the end of l2_packet_receive_ring() */
+		l2->ring_deinit = 1;
+		return;
+	}
+#endif /* CONFIG_L2_PACKET_RING */
+
+	l2_packet_free(l2);
+}
+
+
 int l2_packet_get_ip_addr(struct l2_packet_data *l2, char *buf, size_t len)
 {
 	int s;
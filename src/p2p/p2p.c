@@ -102,7 +102,6 @@ void p2p_expire_peers(struct p2p_data *p2p)
 
 		p2p_dbg(p2p, "Expiring old peer entry " MACSTR,
 			MAC2STR(dev->info.p2p_device_addr));
-		dl_list_del(&dev->list);
 		p2p_device_free(p2p, dev);
 	}
 }
@@ -392,7 +391,8 @@ static void p2p_device_clear_reported(struct p2p_data *p2p)
 struct p2p_device * p2p_get_device(struct p2p_data *p2p, const u8 *addr)
 {
 	struct p2p_device *dev;
-	dl_list_for_each(dev, &p2p->devices, struct p2p_device, list) {
+	dl_list_for_each(dev, &p2p->dev_hash[P2P_DEV_HASH(addr)],
+			 struct p2p_device, hlist) {
 		if (ether_addr_equal(dev->info.p2p_device_addr, addr))
 			return dev;
 	}
@@ -430,24 +430,28 @@ struct p2p_device * p2p_get_device_interface(struct p2p_data *p2p,
 static struct p2p_device * p2p_create_device(struct p2p_data *p2p,
 					     const u8 *addr)
 {
-	struct p2p_device *dev, *oldest = NULL;
-	size_t count = 0;
+	struct p2p_device *dev, *oldest;
 
 	dev = p2p_get_device(p2p, addr);
 	if (dev)
 		return dev;
 
-	dl_list_for_each(dev, &p2p->devices, struct p2p_device, list) {
-		count++;
-		if (oldest == NULL ||
-		    os_reltime_before(&dev->last_seen, &oldest->last_seen))
-			oldest = dev;
-	}
-	if (count + 1 > p2p->cfg->max_peers && oldest) {
+	/* More than one entry may need to be removed if max_peers has been
+	 * lowered at runtime */
+	while (p2p->num_devices && p2p->num_devices + 1 > p2p->cfg->max_peers) {
+		oldest = NULL;
+		dl_list_for_each(dev, &p2p->devices, struct p2p_device, list) {
+			if (oldest == NULL ||
+			    os_reltime_before(&dev->last_seen,
+					      &oldest->last_seen))
+				oldest = dev;
+		}
+		p2p->num_devices_evicted++;
 		p2p_dbg(p2p,
 			"Remove oldest peer entry to make room for a new peer "
-			MACSTR, MAC2STR(oldest->info.p2p_device_addr));
-		dl_list_del(&oldest->list);
+			MACSTR " (%u peers evicted)",
+			MAC2STR(oldest->info.p2p_device_addr),
+			p2p->num_devices_evicted);
 		p2p_device_free(p2p, oldest);
 	}
 
@@ -455,6 +459,8 @@ static struct p2p_device * p2p_create_device(struct p2p_data *p2p,
 	if (dev == NULL)
 		return NULL;
 	dl_list_add(&p2p->devices, &dev->list);
+	dl_list_add(&p2p->dev_hash[P2P_DEV_HASH(addr)], &dev->hlist);
+	p2p->num_devices++;
 	os_memcpy(dev->info.p2p_device_addr, addr, ETH_ALEN);
 	dev->support_6ghz = false;
 
@@ -946,6 +952,10 @@ static void p2p_device_free(struct p2p_data *p2p, struct p2p_device *dev)
 {
 	int i;
 
+	dl_list_del(&dev->list);
+	dl_list_del(&dev->hlist);
+	p2p->num_devices--;
+
 	if (p2p->go_neg_peer == dev) {
 		/*
 		 * If GO Negotiation is in progress, report that it has failed.
@@ -3140,6 +3150,7 @@ static int p2p_pairing_info_init(struct p2p_data *p2p)
 struct p2p_data * p2p_init(const struct p2p_config *cfg)
 {
 	struct p2p_data *p2p;
+	unsigned int i;
 
 	if (cfg->max_peers < 1 ||
 	    cfg->passphrase_len < 8 || cfg->passphrase_len > 63)
@@ -3188,6 +3199,8 @@ struct p2p_data * p2p_init(const struct p2p_config *cfg)
 	p2p->dev_capab |= P2P_DEV_CAPAB_CLIENT_DISCOVERABILITY;
 
 	dl_list_init(&p2p->devices);
+	for (i = 0; i < P2P_DEV_HASH_SIZE; i++)
+		dl_list_init(&p2p->dev_hash[i]);
 
 	p2p->go_timeout = 100;
 	p2p->client_timeout = 20;
@@ -3252,10 +3265,8 @@ void p2p_flush(struct p2p_data *p2p)
 	p2p_ext_listen(p2p, 0, 0);
 	p2p_stop_find(p2p);
 	dl_list_for_each_safe(dev, prev, &p2p->devices, struct p2p_device,
-			      list) {
-		dl_list_del(&dev->list);
+			      list)
 		p2p_device_free(p2p, dev);
-	}
 	p2p_free_sd_queries(p2p);
 	p2p->ssid_set = 0;
 	p2ps_prov_free(p2p);
@@ -5875,6 +5886,15 @@ int p2p_set_passphrase_len(struct p2p_data *p2p, unsigned int len)
 }
 
 
+int p2p_set_max_peers(struct p2p_data *p2p, size_t max_peers)
+{
+	if (max_peers < 1)
+		return -1;
+	p2p->cfg->max_peers = max_peers;
+	return 0;
+}
+
+
 void p2p_set_vendor_elems(struct p2p_data *p2p, struct wpabuf **vendor_elem)
 {
 	p2p->vendor_elem = vendor_elem;
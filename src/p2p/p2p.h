@@ -2731,6 +2731,8 @@ void p2p_set_authorized_oob_dev_pw_id(struct p2p_data *p2p, u16 dev_pw_id,
 
 int p2p_set_passphrase_len(struct p2p_data *p2p, unsigned int len);
 
+int p2p_set_max_peers(struct p2p_data *p2p, size_t max_peers);
+
 void p2p_loop_on_known_peers(struct p2p_data *p2p,
 			     void (*peer_callback)(struct p2p_peer_info *peer,
 						   void *user_data),
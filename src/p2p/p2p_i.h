@@ -64,11 +64,15 @@ struct p2p_bootstrap_params {
 	int comeback_after;
 };
 
+#define P2P_DEV_HASH_SIZE 256
+#define P2P_DEV_HASH(addr) ((addr)[5])
+
 /**
  * struct p2p_device - P2P Device data (internal to P2P module)
  */
 struct p2p_device {
 	struct dl_list list;
+	struct dl_list hlist; /* entry in p2p_data::dev_hash[] */
 	struct os_reltime last_seen;
 	int listen_freq;
 	int oob_go_neg_freq;
@@ -354,6 +358,21 @@ struct p2p_data {
 	 */
 	struct dl_list devices;
 
+	/**
+	 * dev_hash - Hash table of devices by P2P Device Address
+	 */
+	struct dl_list dev_hash[P2P_DEV_HASH_SIZE];
+
+	/**
+	 * num_devices - Number of entries in the devices list
+	 */
+	unsigned int num_devices;
+
+	/**
+	 * num_devices_evicted - Number of peers removed due to max_peers
+	 */
+	unsigned int num_devices_evicted;
+
 	/**
 	 * go_neg_peer - Pointer to GO Negotiation peer
 	 */
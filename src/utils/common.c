@@ -1125,6 +1125,31 @@ char * str_token(char *str, const char *delim, char **context)
 }
 
 
+/**
+ * str_line - Get next line from a string
+ * @context: Pointer to the current position within a NUL terminated string
+ *	that is modified in place. Updated to point to the following line.
+ * Returns: The next line without the terminating newline or NULL if the end
+ *	of the string has been reached.
+ */
+char * str_line(char **context)
+{
+	char *line = *context, *pos;
+
+	if (!line || !*line)
+		return NULL;
+
+	pos = line;
+	while (*pos && *pos != '\n')
+		pos++;
+	if (*pos)
+		*pos++ = '\0';
+	*context = pos;
+
+	return line;
+}
+
+
 size_t utf8_unescape(const char *inp, size_t in_size,
 		     char *outp, size_t out_size)
 {
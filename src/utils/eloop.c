@@ -33,17 +33,30 @@
 
 #ifdef CONFIG_ELOOP_EPOLL
 #include <sys/epoll.h>
+#include <sys/timerfd.h>
 #endif /* CONFIG_ELOOP_EPOLL */
 
 #ifdef CONFIG_ELOOP_KQUEUE
 #include <sys/event.h>
 #endif /* CONFIG_ELOOP_KQUEUE */
 
+#ifdef CONFIG_ELOOP_THREADS
+#include <fcntl.h>
+#include <pthread.h>
+#endif /* CONFIG_ELOOP_THREADS */
+
 struct eloop_sock {
 	int sock;
 	void *eloop_data;
 	void *user_data;
 	eloop_sock_handler handler;
+#ifdef CONFIG_ELOOP_EPOLL
+	/* Registration generation; stored with the epoll event so that events
+	 * for a socket that was unregistered (and possibly replaced with
+	 * another socket using the same fd) during the same dispatch pass can
+	 * be recognized as stale. 0 is used for internal fds. */
+	u32 gen;
+#endif /* CONFIG_ELOOP_EPOLL */
 	WPA_TRACE_REF(eloop);
 	WPA_TRACE_REF(user);
 	WPA_TRACE_INFO
@@ -67,6 +80,15 @@ struct eloop_signal {
 	int signaled;
 };
 
+#ifdef CONFIG_ELOOP_THREADS
+struct eloop_post_msg {
+	struct dl_list list;
+	eloop_timeout_handler handler;
+	void *eloop_data;
+	void *user_data;
+};
+#endif /* CONFIG_ELOOP_THREADS */
+
 struct eloop_sock_table {
 	size_t count;
 	struct eloop_sock *table;
@@ -92,6 +114,9 @@ struct eloop_data {
 	int epollfd;
 	size_t epoll_max_event_num;
 	struct epoll_event *epoll_events;
+	u32 epoll_gen;
+	int timerfd;
+	struct os_reltime timerfd_armed; /* 0 = not armed */
 #endif /* CONFIG_ELOOP_EPOLL */
 #ifdef CONFIG_ELOOP_KQUEUE
 	int kqueuefd;
@@ -110,9 +135,22 @@ struct eloop_data {
 	int pending_terminate;
 
 	int terminate;
+
+#ifdef CONFIG_ELOOP_THREADS
+	/* Messages posted from other threads; protected by post_lock */
+	pthread_mutex_t post_lock;
+	struct dl_list post_queue; /* struct eloop_post_msg */
+	int post_pipe[2];
+#endif /* CONFIG_ELOOP_THREADS */
 };
 
-static struct eloop_data eloop;
+static struct eloop_data eloop_main;
+#ifdef CONFIG_ELOOP_THREADS
+/* Event loop instance used by the calling thread */
+static __thread struct eloop_data *eloop = &eloop_main;
+#else /* CONFIG_ELOOP_THREADS */
+static struct eloop_data *eloop = &eloop_main;
+#endif /* CONFIG_ELOOP_THREADS */
 
 
 #ifdef WPA_TRACE
@@ -160,34 +198,291 @@ static void eloop_trace_sock_remove_ref(struct eloop_sock_table *table)
 #endif /* WPA_TRACE */
 
 
+#ifdef CONFIG_ELOOP_EPOLL
+
+static void eloop_timerfd_init(void)
+{
+	struct epoll_event ev;
+
+	/*
+	 * Use a timerfd for the next timeout instead of the millisecond
+	 * granularity epoll_wait() timeout. If this is not available, fall
+	 * back to the epoll_wait() timeout.
+	 */
+	eloop->timerfd = timerfd_create(CLOCK_MONOTONIC,
+					TFD_NONBLOCK | TFD_CLOEXEC);
+	if (eloop->timerfd < 0) {
+		wpa_printf(MSG_DEBUG, "eloop: timerfd_create failed: %s",
+			   strerror(errno));
+		return;
+	}
+
+	os_memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.u64 = (u32) eloop->timerfd; /* generation 0 */
+	if (epoll_ctl(eloop->epollfd, EPOLL_CTL_ADD, eloop->timerfd, &ev) < 0) {
+		wpa_printf(MSG_ERROR, "%s: epoll_ctl(ADD) for timerfd failed: %s",
+			   __func__, strerror(errno));
+		close(eloop->timerfd);
+		eloop->timerfd = -1;
+	}
+}
+
+
+static int eloop_timerfd_arm(struct eloop_timeout *timeout,
+			     struct os_reltime *tv)
+{
+	struct itimerspec its;
+
+	if (eloop->timerfd < 0)
+		return -1;
+	if (os_reltime_initialized(&eloop->timerfd_armed) &&
+	    eloop->timerfd_armed.sec == timeout->time.sec &&
+	    eloop->timerfd_armed.usec == timeout->time.usec)
+		return 0; /* already armed for this timeout */
+
+	os_memset(&its, 0, sizeof(its));
+	its.it_value.tv_sec = tv->sec;
+	its.it_value.tv_nsec = tv->usec * 1000L;
+	if (timerfd_settime(eloop->timerfd, 0, &its, NULL) < 0) {
+		wpa_printf(MSG_ERROR, "eloop: timerfd_settime failed: %s",
+			   strerror(errno));
+		return -1;
+	}
+	eloop->timerfd_armed = timeout->time;
+	return 0;
+}
+
+
+static void eloop_timerfd_read(void)
+{
+	u64 expirations;
+
+	if (read(eloop->timerfd, &expirations, sizeof(expirations)) < 0 &&
+	    errno != EAGAIN)
+		wpa_printf(MSG_DEBUG, "eloop: timerfd read failed: %s",
+			   strerror(errno));
+	os_memset(&eloop->timerfd_armed, 0, sizeof(eloop->timerfd_armed));
+}
+
+#endif /* CONFIG_ELOOP_EPOLL */
+
+
+#ifdef CONFIG_ELOOP_THREADS
+
+static void eloop_post_receive(int sock, void *eloop_ctx, void *sock_ctx)
+{
+	struct eloop_post_msg *msg, *tmp;
+	struct dl_list queue;
+	u8 buf[64];
+
+	while (read(sock, buf, sizeof(buf)) == sizeof(buf))
+		;
+
+	dl_list_init(&queue);
+	pthread_mutex_lock(&eloop->post_lock);
+	while ((msg = dl_list_first(&eloop->post_queue, struct eloop_post_msg,
+				    list))) {
+		dl_list_del(&msg->list);
+		dl_list_add_tail(&queue, &msg->list);
+	}
+	pthread_mutex_unlock(&eloop->post_lock);
+
+	dl_list_for_each_safe(msg, tmp, &queue, struct eloop_post_msg, list) {
+		dl_list_del(&msg->list);
+		msg->handler(msg->eloop_data, msg->user_data);
+		os_free(msg);
+	}
+}
+
+
+static int eloop_post_init(void)
+{
+	int i;
+
+	dl_list_init(&eloop->post_queue);
+	if (pthread_mutex_init(&eloop->post_lock, NULL) != 0)
+		return -1;
+	if (pipe(eloop->post_pipe) < 0) {
+		wpa_printf(MSG_ERROR, "eloop: pipe failed: %s",
+			   strerror(errno));
+		eloop->post_pipe[0] = eloop->post_pipe[1] = -1;
+		pthread_mutex_destroy(&eloop->post_lock);
+		return -1;
+	}
+	for (i = 0; i < 2; i++) {
+		if (fcntl(eloop->post_pipe[i], F_SETFL, O_NONBLOCK) < 0 ||
+		    fcntl(eloop->post_pipe[i], F_SETFD, FD_CLOEXEC) < 0) {
+			wpa_printf(MSG_ERROR, "eloop: fcntl failed: %s",
+				   strerror(errno));
+			return -1;
+		}
+	}
+
+	return eloop_register_read_sock(eloop->post_pipe[0],
+					eloop_post_receive, NULL, NULL);
+}
+
+
+static void eloop_post_deinit(void)
+{
+	struct eloop_post_msg *msg, *tmp;
+
+	if (eloop->post_pipe[0] < 0)
+		return;
+
+	eloop_unregister_read_sock(eloop->post_pipe[0]);
+	close(eloop->post_pipe[0]);
+	close(eloop->post_pipe[1]);
+	eloop->post_pipe[0] = eloop->post_pipe[1] = -1;
+
+	dl_list_for_each_safe(msg, tmp, &eloop->post_queue,
+			      struct eloop_post_msg, list) {
+		wpa_printf(MSG_INFO,
+			   "ELOOP: dropping posted message handler=%p eloop_data=%p user_data=%p",
+			   msg->handler, msg->eloop_data, msg->user_data);
+		dl_list_del(&msg->list);
+		os_free(msg);
+	}
+	pthread_mutex_destroy(&eloop->post_lock);
+}
+
+
+struct eloop_data * eloop_instance_new(void)
+{
+	struct eloop_data *e, *prev;
+
+	e = os_zalloc(sizeof(*e));
+	if (!e)
+		return NULL;
+
+	prev = eloop_instance_set(e);
+	if (eloop_init() < 0) {
+		eloop_destroy();
+		os_free(e);
+		e = NULL;
+	}
+	eloop_instance_set(prev);
+
+	return e;
+}
+
+
+void eloop_instance_free(struct eloop_data *e)
+{
+	struct eloop_data *prev;
+
+	if (!e || e == &eloop_main)
+		return;
+
+	prev = eloop_instance_set(e);
+	eloop_destroy();
+	eloop_instance_set(prev == e ? NULL : prev);
+	os_free(e);
+}
+
+
+struct eloop_data * eloop_instance_set(struct eloop_data *e)
+{
+	struct eloop_data *prev = eloop;
+
+	eloop = e ? e : &eloop_main;
+	return prev;
+}
+
+
+struct eloop_data * eloop_instance_get(void)
+{
+	return eloop;
+}
+
+
+int eloop_instance_post(struct eloop_data *e, eloop_timeout_handler handler,
+			void *eloop_data, void *user_data)
+{
+	struct eloop_post_msg *msg;
+	u8 wake = 0;
+
+	if (!e)
+		e = &eloop_main;
+	if (e->post_pipe[1] < 0)
+		return -1;
+
+	msg = os_zalloc(sizeof(*msg));
+	if (!msg)
+		return -1;
+	msg->handler = handler;
+	msg->eloop_data = eloop_data;
+	msg->user_data = user_data;
+
+	pthread_mutex_lock(&e->post_lock);
+	dl_list_add_tail(&e->post_queue, &msg->list);
+	pthread_mutex_unlock(&e->post_lock);
+
+	/* A full pipe already guarantees a pending wakeup */
+	if (write(e->post_pipe[1], &wake, 1) < 0 && errno != EAGAIN &&
+	    errno != EWOULDBLOCK)
+		wpa_printf(MSG_ERROR, "eloop: post wakeup failed: %s",
+			   strerror(errno));
+
+	return 0;
+}
+
+#endif /* CONFIG_ELOOP_THREADS */
+
+
+static size_t eloop_internal_readers(void)
+{
+#ifdef CONFIG_ELOOP_THREADS
+	/* The cross-thread post pipe does not keep eloop_run() alive */
+	return eloop->post_pipe[0] >= 0 ? 1 : 0;
+#else /* CONFIG_ELOOP_THREADS */
+	return 0;
+#endif /* CONFIG_ELOOP_THREADS */
+}
+
+
 int eloop_init(void)
 {
-	os_memset(&eloop, 0, sizeof(eloop));
-	dl_list_init(&eloop.timeout);
+	os_memset(eloop, 0, sizeof(*eloop));
+	dl_list_init(&eloop->timeout);
+#ifdef CONFIG_ELOOP_THREADS
+	eloop->post_pipe[0] = eloop->post_pipe[1] = -1;
+#endif /* CONFIG_ELOOP_THREADS */
 #ifdef CONFIG_ELOOP_EPOLL
-	eloop.epollfd = epoll_create1(0);
-	if (eloop.epollfd < 0) {
+	eloop->timerfd = -1;
+	eloop->epollfd = epoll_create1(0);
+	if (eloop->epollfd < 0) {
 		wpa_printf(MSG_ERROR, "%s: epoll_create1 failed. %s",
 			   __func__, strerror(errno));
 		return -1;
 	}
+	eloop->epoll_events = os_calloc(8, sizeof(struct epoll_event));
+	if (!eloop->epoll_events)
+		return -1;
+	eloop->epoll_max_event_num = 8;
+	eloop_timerfd_init();
 #endif /* CONFIG_ELOOP_EPOLL */
 #ifdef CONFIG_ELOOP_KQUEUE
-	eloop.kqueuefd = kqueue();
-	if (eloop.kqueuefd < 0) {
+	eloop->kqueuefd = kqueue();
+	if (eloop->kqueuefd < 0) {
 		wpa_printf(MSG_ERROR, "%s: kqueue failed: %s",
 			   __func__, strerror(errno));
 		return -1;
 	}
 #endif /* CONFIG_ELOOP_KQUEUE */
 #if defined(CONFIG_ELOOP_EPOLL) || defined(CONFIG_ELOOP_KQUEUE)
-	eloop.readers.type = EVENT_TYPE_READ;
-	eloop.writers.type = EVENT_TYPE_WRITE;
-	eloop.exceptions.type = EVENT_TYPE_EXCEPTION;
+	eloop->readers.type = EVENT_TYPE_READ;
+	eloop->writers.type = EVENT_TYPE_WRITE;
+	eloop->exceptions.type = EVENT_TYPE_EXCEPTION;
 #endif /* CONFIG_ELOOP_EPOLL || CONFIG_ELOOP_KQUEUE */
 #ifdef WPA_TRACE
 	signal(SIGSEGV, eloop_sigsegv_handler);
 #endif /* WPA_TRACE */
+#ifdef CONFIG_ELOOP_THREADS
+	if (eloop_post_init() < 0)
+		return -1;
+#endif /* CONFIG_ELOOP_THREADS */
 	return 0;
 }
 
@@ -214,8 +509,8 @@ static int eloop_sock_queue(int sock, eloop_event_type type)
 		ev.events = EPOLLERR | EPOLLHUP;
 		break;
 	}
-	ev.data.fd = sock;
-	if (epoll_ctl(eloop.epollfd, EPOLL_CTL_ADD, sock, &ev) < 0) {
+	ev.data.u64 = ((u64) eloop->fd_table[sock].gen << 32) | (u32) sock;
+	if (epoll_ctl(eloop->epollfd, EPOLL_CTL_ADD, sock, &ev) < 0) {
 		wpa_printf(MSG_ERROR, "%s: epoll_ctl(ADD) for fd=%d failed: %s",
 			   __func__, sock, strerror(errno));
 		return -1;
@@ -245,7 +540,7 @@ static int eloop_sock_queue(int sock, eloop_event_type type)
 	struct kevent ke;
 
 	EV_SET(&ke, sock, event_type_kevent_filter(type), EV_ADD, 0, 0, 0);
-	if (kevent(eloop.kqueuefd, &ke, 1, NULL, 0, NULL) == -1) {
+	if (kevent(eloop->kqueuefd, &ke, 1, NULL, 0, NULL) == -1) {
 		wpa_printf(MSG_ERROR, "%s: kevent(ADD) for fd=%d failed: %s",
 			   __func__, sock, strerror(errno));
 		return -1;
@@ -273,57 +568,57 @@ static int eloop_sock_table_add_sock(struct eloop_sock_table *table,
 	struct eloop_sock *tmp;
 	int new_max_sock;
 
-	if (sock > eloop.max_sock)
+	if (sock > eloop->max_sock)
 		new_max_sock = sock;
 	else
-		new_max_sock = eloop.max_sock;
+		new_max_sock = eloop->max_sock;
 
 	if (table == NULL)
 		return -1;
 
 #ifdef CONFIG_ELOOP_POLL
-	if ((size_t) new_max_sock >= eloop.max_pollfd_map) {
+	if ((size_t) new_max_sock >= eloop->max_pollfd_map) {
 		struct pollfd **nmap;
-		nmap = os_realloc_array(eloop.pollfds_map, new_max_sock + 50,
+		nmap = os_realloc_array(eloop->pollfds_map, new_max_sock + 50,
 					sizeof(struct pollfd *));
 		if (nmap == NULL)
 			return -1;
 
-		eloop.max_pollfd_map = new_max_sock + 50;
-		eloop.pollfds_map = nmap;
+		eloop->max_pollfd_map = new_max_sock + 50;
+		eloop->pollfds_map = nmap;
 	}
 
-	if (eloop.count + 1 > eloop.max_poll_fds) {
+	if (eloop->count + 1 > eloop->max_poll_fds) {
 		struct pollfd *n;
-		size_t nmax = eloop.count + 1 + 50;
+		size_t nmax = eloop->count + 1 + 50;
 
-		n = os_realloc_array(eloop.pollfds, nmax,
+		n = os_realloc_array(eloop->pollfds, nmax,
 				     sizeof(struct pollfd));
 		if (n == NULL)
 			return -1;
 
-		eloop.max_poll_fds = nmax;
-		eloop.pollfds = n;
+		eloop->max_poll_fds = nmax;
+		eloop->pollfds = n;
 	}
 #endif /* CONFIG_ELOOP_POLL */
 #if defined(CONFIG_ELOOP_EPOLL) || defined(CONFIG_ELOOP_KQUEUE)
-	if (new_max_sock >= eloop.max_fd) {
+	if (new_max_sock >= eloop->max_fd) {
 		next = new_max_sock + 16;
-		temp_table = os_realloc_array(eloop.fd_table, next,
+		temp_table = os_realloc_array(eloop->fd_table, next,
 					      sizeof(struct eloop_sock));
 		if (temp_table == NULL)
 			return -1;
 
-		eloop.max_fd = next;
-		eloop.fd_table = temp_table;
+		eloop->max_fd = next;
+		eloop->fd_table = temp_table;
 	}
 #endif /* CONFIG_ELOOP_EPOLL || CONFIG_ELOOP_KQUEUE */
 
 #ifdef CONFIG_ELOOP_EPOLL
-	if (eloop.count + 1 > eloop.epoll_max_event_num) {
-		next = eloop.epoll_max_event_num == 0 ? 8 :
-			eloop.epoll_max_event_num * 2;
-		temp_events = os_realloc_array(eloop.epoll_events, next,
+	if (eloop->count + 1 > eloop->epoll_max_event_num) {
+		next = eloop->epoll_max_event_num == 0 ? 8 :
+			eloop->epoll_max_event_num * 2;
+		temp_events = os_realloc_array(eloop->epoll_events, next,
 					       sizeof(struct epoll_event));
 		if (temp_events == NULL) {
 			wpa_printf(MSG_ERROR, "%s: malloc for epoll failed: %s",
@@ -331,13 +626,13 @@ static int eloop_sock_table_add_sock(struct eloop_sock_table *table,
 			return -1;
 		}
 
-		eloop.epoll_max_event_num = next;
-		eloop.epoll_events = temp_events;
+		eloop->epoll_max_event_num = next;
+		eloop->epoll_events = temp_events;
 	}
 #endif /* CONFIG_ELOOP_EPOLL */
 #ifdef CONFIG_ELOOP_KQUEUE
-	if (eloop.count + 1 > eloop.kqueue_nevents) {
-		next = eloop.kqueue_nevents == 0 ? 8 : eloop.kqueue_nevents * 2;
+	if (eloop->count + 1 > eloop->kqueue_nevents) {
+		next = eloop->kqueue_nevents == 0 ? 8 : eloop->kqueue_nevents * 2;
 		temp_events = os_malloc(next * sizeof(*temp_events));
 		if (!temp_events) {
 			wpa_printf(MSG_ERROR,
@@ -346,9 +641,9 @@ static int eloop_sock_table_add_sock(struct eloop_sock_table *table,
 			return -1;
 		}
 
-		os_free(eloop.kqueue_events);
-		eloop.kqueue_events = temp_events;
-		eloop.kqueue_nevents = next;
+		os_free(eloop->kqueue_events);
+		eloop->kqueue_events = temp_events;
+		eloop->kqueue_nevents = next;
 	}
 #endif /* CONFIG_ELOOP_KQUEUE */
 
@@ -364,19 +659,26 @@ static int eloop_sock_table_add_sock(struct eloop_sock_table *table,
 	tmp[table->count].eloop_data = eloop_data;
 	tmp[table->count].user_data = user_data;
 	tmp[table->count].handler = handler;
+#ifdef CONFIG_ELOOP_EPOLL
+	if (++eloop->epoll_gen == 0)
+		eloop->epoll_gen = 1;
+	tmp[table->count].gen = eloop->epoll_gen;
+#endif /* CONFIG_ELOOP_EPOLL */
 	wpa_trace_record(&tmp[table->count]);
 	table->count++;
 	table->table = tmp;
-	eloop.max_sock = new_max_sock;
-	eloop.count++;
+	eloop->max_sock = new_max_sock;
+	eloop->count++;
 	table->changed = 1;
 	eloop_trace_sock_add_ref(table);
 
 #if defined(CONFIG_ELOOP_EPOLL) || defined(CONFIG_ELOOP_KQUEUE)
-	if (eloop_sock_queue(sock, table->type) < 0)
-		return -1;
-	os_memcpy(&eloop.fd_table[sock], &table->table[table->count - 1],
+	os_memcpy(&eloop->fd_table[sock], &table->table[table->count - 1],
 		  sizeof(struct eloop_sock));
+	if (eloop_sock_queue(sock, table->type) < 0) {
+		os_memset(&eloop->fd_table[sock], 0, sizeof(struct eloop_sock));
+		return -1;
+	}
 #endif /* CONFIG_ELOOP_EPOLL || CONFIG_ELOOP_KQUEUE */
 	return 0;
 }
@@ -406,26 +708,26 @@ static void eloop_sock_table_remove_sock(struct eloop_sock_table *table,
 			   sizeof(struct eloop_sock));
 	}
 	table->count--;
-	eloop.count--;
+	eloop->count--;
 	table->changed = 1;
 	eloop_trace_sock_add_ref(table);
 #ifdef CONFIG_ELOOP_EPOLL
-	if (epoll_ctl(eloop.epollfd, EPOLL_CTL_DEL, sock, NULL) < 0) {
+	if (epoll_ctl(eloop->epollfd, EPOLL_CTL_DEL, sock, NULL) < 0) {
 		wpa_printf(MSG_ERROR, "%s: epoll_ctl(DEL) for fd=%d failed: %s",
 			   __func__, sock, strerror(errno));
 		return;
 	}
-	os_memset(&eloop.fd_table[sock], 0, sizeof(struct eloop_sock));
+	os_memset(&eloop->fd_table[sock], 0, sizeof(struct eloop_sock));
 #endif /* CONFIG_ELOOP_EPOLL */
 #ifdef CONFIG_ELOOP_KQUEUE
 	EV_SET(&ke, sock, event_type_kevent_filter(table->type), EV_DELETE, 0,
 	       0, 0);
-	if (kevent(eloop.kqueuefd, &ke, 1, NULL, 0, NULL) < 0) {
+	if (kevent(eloop->kqueuefd, &ke, 1, NULL, 0, NULL) < 0) {
 		wpa_printf(MSG_ERROR, "%s: kevent(DEL) for fd=%d failed: %s",
 			   __func__, sock, strerror(errno));
 		return;
 	}
-	os_memset(&eloop.fd_table[sock], 0, sizeof(struct eloop_sock));
+	os_memset(&eloop->fd_table[sock], 0, sizeof(struct eloop_sock));
 #endif /* CONFIG_ELOOP_KQUEUE */
 }
 
@@ -613,21 +915,38 @@ static void eloop_sock_table_dispatch(struct eloop_sock_table *table,
 
 
 #ifdef CONFIG_ELOOP_EPOLL
-static void eloop_sock_table_dispatch(struct epoll_event *events, int nfds)
+static void eloop_sock_table_dispatch(int nfds)
 {
 	struct eloop_sock *table;
-	int i;
+	int i, fd;
+	u64 data;
+	u32 gen;
 
+	/*
+	 * Dispatch all reported events even if the handlers modify the socket
+	 * tables. The registration generation is used to skip events for
+	 * sockets that have been unregistered after epoll_wait() returned.
+	 *
+	 * A handler registering a new socket may reallocate epoll_events, so
+	 * the event array must be re-read through eloop on each iteration
+	 * instead of holding a pointer to it across handler calls.
+	 */
 	for (i = 0; i < nfds; i++) {
-		table = &eloop.fd_table[events[i].data.fd];
-		if (table->handler == NULL)
+		data = eloop->epoll_events[i].data.u64;
+		fd = (int) (u32) data;
+		gen = data >> 32;
+		if (gen == 0) {
+			if (fd == eloop->timerfd)
+				eloop_timerfd_read();
+			continue;
+		}
+		if (fd >= eloop->max_fd)
+			continue;
+		table = &eloop->fd_table[fd];
+		if (table->handler == NULL || table->gen != gen)
 			continue;
 		table->handler(table->sock, table->eloop_data,
 			       table->user_data);
-		if (eloop.readers.changed ||
-		    eloop.writers.changed ||
-		    eloop.exceptions.changed)
-			break;
 	}
 }
 #endif /* CONFIG_ELOOP_EPOLL */
@@ -641,14 +960,14 @@ static void eloop_sock_table_dispatch(struct kevent *events, int nfds)
 	int i;
 
 	for (i = 0; i < nfds; i++) {
-		table = &eloop.fd_table[events[i].ident];
+		table = &eloop->fd_table[events[i].ident];
 		if (table->handler == NULL)
 			continue;
 		table->handler(table->sock, table->eloop_data,
 			       table->user_data);
-		if (eloop.readers.changed ||
-		    eloop.writers.changed ||
-		    eloop.exceptions.changed)
+		if (eloop->readers.changed ||
+		    eloop->writers.changed ||
+		    eloop->exceptions.changed)
 			break;
 	}
 }
@@ -675,19 +994,19 @@ int eloop_sock_requeue(void)
 	int r = 0;
 
 #ifdef CONFIG_ELOOP_KQUEUE
-	close(eloop.kqueuefd);
-	eloop.kqueuefd = kqueue();
-	if (eloop.kqueuefd < 0) {
+	close(eloop->kqueuefd);
+	eloop->kqueuefd = kqueue();
+	if (eloop->kqueuefd < 0) {
 		wpa_printf(MSG_ERROR, "%s: kqueue failed: %s",
 			   __func__, strerror(errno));
 		return -1;
 	}
 
-	if (eloop_sock_table_requeue(&eloop.readers) < 0)
+	if (eloop_sock_table_requeue(&eloop->readers) < 0)
 		r = -1;
-	if (eloop_sock_table_requeue(&eloop.writers) < 0)
+	if (eloop_sock_table_requeue(&eloop->writers) < 0)
 		r = -1;
-	if (eloop_sock_table_requeue(&eloop.exceptions) < 0)
+	if (eloop_sock_table_requeue(&eloop->exceptions) < 0)
 		r = -1;
 #endif /* CONFIG_ELOOP_KQUEUE */
 
@@ -736,11 +1055,11 @@ static struct eloop_sock_table *eloop_get_sock_table(eloop_event_type type)
 {
 	switch (type) {
 	case EVENT_TYPE_READ:
-		return &eloop.readers;
+		return &eloop->readers;
 	case EVENT_TYPE_WRITE:
-		return &eloop.writers;
+		return &eloop->writers;
 	case EVENT_TYPE_EXCEPTION:
-		return &eloop.exceptions;
+		return &eloop->exceptions;
 	}
 
 	return NULL;
@@ -802,13 +1121,13 @@ int eloop_register_timeout(unsigned int secs, unsigned int usecs,
 	wpa_trace_record(timeout);
 
 	/* Maintain timeouts in order of increasing time */
-	dl_list_for_each(tmp, &eloop.timeout, struct eloop_timeout, list) {
+	dl_list_for_each(tmp, &eloop->timeout, struct eloop_timeout, list) {
 		if (os_reltime_before(&timeout->time, &tmp->time)) {
 			dl_list_add(tmp->list.prev, &timeout->list);
 			return 0;
 		}
 	}
-	dl_list_add_tail(&eloop.timeout, &timeout->list);
+	dl_list_add_tail(&eloop->timeout, &timeout->list);
 
 	return 0;
 
@@ -840,7 +1159,7 @@ int eloop_cancel_timeout(eloop_timeout_handler handler,
 	struct eloop_timeout *timeout, *prev;
 	int removed = 0;
 
-	dl_list_for_each_safe(timeout, prev, &eloop.timeout,
+	dl_list_for_each_safe(timeout, prev, &eloop->timeout,
 			      struct eloop_timeout, list) {
 		if (timeout->handler == handler &&
 		    (timeout->eloop_data == eloop_data ||
@@ -867,7 +1186,7 @@ int eloop_cancel_timeout_one(eloop_timeout_handler handler,
 	os_get_reltime(&now);
 	remaining->sec = remaining->usec = 0;
 
-	dl_list_for_each_safe(timeout, prev, &eloop.timeout,
+	dl_list_for_each_safe(timeout, prev, &eloop->timeout,
 			      struct eloop_timeout, list) {
 		if (timeout->handler == handler &&
 		    (timeout->eloop_data == eloop_data) &&
@@ -888,7 +1207,7 @@ int eloop_is_timeout_registered(eloop_timeout_handler handler,
 {
 	struct eloop_timeout *tmp;
 
-	dl_list_for_each(tmp, &eloop.timeout, struct eloop_timeout, list) {
+	dl_list_for_each(tmp, &eloop->timeout, struct eloop_timeout, list) {
 		if (tmp->handler == handler &&
 		    tmp->eloop_data == eloop_data &&
 		    tmp->user_data == user_data)
@@ -906,7 +1225,7 @@ int eloop_deplete_timeout(unsigned int req_secs, unsigned int req_usecs,
 	struct os_reltime now, requested, remaining;
 	struct eloop_timeout *tmp;
 
-	dl_list_for_each(tmp, &eloop.timeout, struct eloop_timeout, list) {
+	dl_list_for_each(tmp, &eloop->timeout, struct eloop_timeout, list) {
 		if (tmp->handler == handler &&
 		    tmp->eloop_data == eloop_data &&
 		    tmp->user_data == user_data) {
@@ -938,7 +1257,7 @@ int eloop_replenish_timeout(unsigned int req_secs, unsigned int req_usecs,
 	struct os_reltime now, requested, remaining;
 	struct eloop_timeout *tmp;
 
-	dl_list_for_each(tmp, &eloop.timeout, struct eloop_timeout, list) {
+	dl_list_for_each(tmp, &eloop->timeout, struct eloop_timeout, list) {
 		if (tmp->handler == handler &&
 		    tmp->eloop_data == eloop_data &&
 		    tmp->user_data == user_data) {
@@ -981,19 +1300,20 @@ static void eloop_handle_signal(int sig)
 	size_t i;
 
 #ifndef CONFIG_NATIVE_WINDOWS
-	if ((sig == SIGINT || sig == SIGTERM) && !eloop.pending_terminate) {
+	if ((sig == SIGINT || sig == SIGTERM) &&
+	    !eloop_main.pending_terminate) {
 		/* Use SIGALRM to break out from potential busy loops that
 		 * would not allow the program to be killed. */
-		eloop.pending_terminate = 1;
+		eloop_main.pending_terminate = 1;
 		signal(SIGALRM, eloop_handle_alarm);
 		alarm(2);
 	}
 #endif /* CONFIG_NATIVE_WINDOWS */
 
-	eloop.signaled++;
-	for (i = 0; i < eloop.signal_count; i++) {
-		if (eloop.signals[i].sig == sig) {
-			eloop.signals[i].signaled++;
+	eloop_main.signaled++;
+	for (i = 0; i < eloop_main.signal_count; i++) {
+		if (eloop_main.signals[i].sig == sig) {
+			eloop_main.signals[i].signaled++;
 			break;
 		}
 	}
@@ -1004,22 +1324,23 @@ static void eloop_process_pending_signals(void)
 {
 	size_t i;
 
-	if (eloop.signaled == 0)
+	if (eloop_main.signaled == 0)
 		return;
-	eloop.signaled = 0;
+	eloop_main.signaled = 0;
 
-	if (eloop.pending_terminate) {
+	if (eloop_main.pending_terminate) {
 #ifndef CONFIG_NATIVE_WINDOWS
 		alarm(0);
 #endif /* CONFIG_NATIVE_WINDOWS */
-		eloop.pending_terminate = 0;
+		eloop_main.pending_terminate = 0;
 	}
 
-	for (i = 0; i < eloop.signal_count; i++) {
-		if (eloop.signals[i].signaled) {
-			eloop.signals[i].signaled = 0;
-			eloop.signals[i].handler(eloop.signals[i].sig,
-						 eloop.signals[i].user_data);
+	for (i = 0; i < eloop_main.signal_count; i++) {
+		if (eloop_main.signals[i].signaled) {
+			eloop_main.signals[i].signaled = 0;
+			eloop_main.signals[i].handler(
+				eloop_main.signals[i].sig,
+				eloop_main.signals[i].user_data);
 		}
 	}
 }
@@ -1030,17 +1351,18 @@ int eloop_register_signal(int sig, eloop_signal_handler handler,
 {
 	struct eloop_signal *tmp;
 
-	tmp = os_realloc_array(eloop.signals, eloop.signal_count + 1,
+	tmp = os_realloc_array(eloop_main.signals,
+			       eloop_main.signal_count + 1,
 			       sizeof(struct eloop_signal));
 	if (tmp == NULL)
 		return -1;
 
-	tmp[eloop.signal_count].sig = sig;
-	tmp[eloop.signal_count].user_data = user_data;
-	tmp[eloop.signal_count].handler = handler;
-	tmp[eloop.signal_count].signaled = 0;
-	eloop.signal_count++;
-	eloop.signals = tmp;
+	tmp[eloop_main.signal_count].sig = sig;
+	tmp[eloop_main.signal_count].user_data = user_data;
+	tmp[eloop_main.signal_count].handler = handler;
+	tmp[eloop_main.signal_count].signaled = 0;
+	eloop_main.signal_count++;
+	eloop_main.signals = tmp;
 	signal(sig, eloop_handle_signal);
 
 	return 0;
@@ -1095,12 +1417,13 @@ void eloop_run(void)
 		goto out;
 #endif /* CONFIG_ELOOP_SELECT */
 
-	while (!eloop.terminate &&
-	       (!dl_list_empty(&eloop.timeout) || eloop.readers.count > 0 ||
-		eloop.writers.count > 0 || eloop.exceptions.count > 0)) {
+	while (!eloop->terminate &&
+	       (!dl_list_empty(&eloop->timeout) ||
+		eloop->readers.count > eloop_internal_readers() ||
+		eloop->writers.count > 0 || eloop->exceptions.count > 0)) {
 		struct eloop_timeout *timeout;
 
-		if (eloop.pending_terminate) {
+		if (eloop->pending_terminate) {
 			/*
 			 * This may happen in some corner cases where a signal
 			 * is received during a blocking operation. We need to
@@ -1109,11 +1432,11 @@ void eloop_run(void)
 			 * operation took more than two seconds.
 			 */
 			eloop_process_pending_signals();
-			if (eloop.terminate)
+			if (eloop->terminate)
 				break;
 		}
 
-		timeout = dl_list_first(&eloop.timeout, struct eloop_timeout,
+		timeout = dl_list_first(&eloop->timeout, struct eloop_timeout,
 					list);
 		if (timeout) {
 			os_get_reltime(&now);
@@ -1121,9 +1444,17 @@ void eloop_run(void)
 				os_reltime_sub(&timeout->time, &now, &tv);
 			else
 				tv.sec = tv.usec = 0;
-#if defined(CONFIG_ELOOP_POLL) || defined(CONFIG_ELOOP_EPOLL)
+#ifdef CONFIG_ELOOP_POLL
 			timeout_ms = tv.sec * 1000 + tv.usec / 1000;
-#endif /* defined(CONFIG_ELOOP_POLL) || defined(CONFIG_ELOOP_EPOLL) */
+#endif /* CONFIG_ELOOP_POLL */
+#ifdef CONFIG_ELOOP_EPOLL
+			if (!os_reltime_initialized(&tv))
+				timeout_ms = 0;
+			else if (eloop_timerfd_arm(timeout, &tv) == 0)
+				timeout_ms = -1;
+			else
+				timeout_ms = tv.sec * 1000 + tv.usec / 1000;
+#endif /* CONFIG_ELOOP_EPOLL */
 #ifdef CONFIG_ELOOP_SELECT
 			_tv.tv_sec = tv.sec;
 			_tv.tv_usec = tv.usec;
@@ -1136,33 +1467,35 @@ void eloop_run(void)
 
 #ifdef CONFIG_ELOOP_POLL
 		num_poll_fds = eloop_sock_table_set_fds(
-			&eloop.readers, &eloop.writers, &eloop.exceptions,
-			eloop.pollfds, eloop.pollfds_map,
-			eloop.max_pollfd_map);
-		res = poll(eloop.pollfds, num_poll_fds,
+			&eloop->readers, &eloop->writers, &eloop->exceptions,
+			eloop->pollfds, eloop->pollfds_map,
+			eloop->max_pollfd_map);
+		res = poll(eloop->pollfds, num_poll_fds,
 			   timeout ? timeout_ms : -1);
 #endif /* CONFIG_ELOOP_POLL */
 #ifdef CONFIG_ELOOP_SELECT
-		eloop_sock_table_set_fds(&eloop.readers, rfds);
-		eloop_sock_table_set_fds(&eloop.writers, wfds);
-		eloop_sock_table_set_fds(&eloop.exceptions, efds);
-		res = select(eloop.max_sock + 1, rfds, wfds, efds,
+		eloop_sock_table_set_fds(&eloop->readers, rfds);
+		eloop_sock_table_set_fds(&eloop->writers, wfds);
+		eloop_sock_table_set_fds(&eloop->exceptions, efds);
+		res = select(eloop->max_sock + 1, rfds, wfds, efds,
 			     timeout ? &_tv : NULL);
 #endif /* CONFIG_ELOOP_SELECT */
 #ifdef CONFIG_ELOOP_EPOLL
-		if (eloop.count == 0) {
+		if (eloop->count == 0 &&
+		    (eloop->timerfd < 0 || !timeout)) {
 			res = 0;
 		} else {
-			res = epoll_wait(eloop.epollfd, eloop.epoll_events,
-					 eloop.count, timeout_ms);
+			res = epoll_wait(eloop->epollfd, eloop->epoll_events,
+					 eloop->epoll_max_event_num,
+					 timeout ? timeout_ms : -1);
 		}
 #endif /* CONFIG_ELOOP_EPOLL */
 #ifdef CONFIG_ELOOP_KQUEUE
-		if (eloop.count == 0) {
+		if (eloop->count == 0) {
 			res = 0;
 		} else {
-			res = kevent(eloop.kqueuefd, NULL, 0,
-				     eloop.kqueue_events, eloop.kqueue_nevents,
+			res = kevent(eloop->kqueuefd, NULL, 0,
+				     eloop->kqueue_events, eloop->kqueue_nevents,
 				     timeout ? &ts : NULL);
 		}
 #endif /* CONFIG_ELOOP_KQUEUE */
@@ -1185,15 +1518,16 @@ void eloop_run(void)
 			goto out;
 		}
 
-		eloop.readers.changed = 0;
-		eloop.writers.changed = 0;
-		eloop.exceptions.changed = 0;
+		eloop->readers.changed = 0;
+		eloop->writers.changed = 0;
+		eloop->exceptions.changed = 0;
 
-		eloop_process_pending_signals();
+		if (eloop == &eloop_main)
+			eloop_process_pending_signals();
 
 
 		/* check if some registered timeouts have occurred */
-		timeout = dl_list_first(&eloop.timeout, struct eloop_timeout,
+		timeout = dl_list_first(&eloop->timeout, struct eloop_timeout,
 					list);
 		if (timeout) {
 			os_get_reltime(&now);
@@ -1211,9 +1545,10 @@ void eloop_run(void)
 		if (res <= 0)
 			continue;
 
-		if (eloop.readers.changed ||
-		    eloop.writers.changed ||
-		    eloop.exceptions.changed) {
+#ifndef CONFIG_ELOOP_EPOLL
+		if (eloop->readers.changed ||
+		    eloop->writers.changed ||
+		    eloop->exceptions.changed) {
 			 /*
 			  * Sockets may have been closed and reopened with the
 			  * same FD in the signal or timeout handlers, so we
@@ -1223,26 +1558,27 @@ void eloop_run(void)
 			  */
 			continue;
 		}
+#endif /* CONFIG_ELOOP_EPOLL */
 
 #ifdef CONFIG_ELOOP_POLL
-		eloop_sock_table_dispatch(&eloop.readers, &eloop.writers,
-					  &eloop.exceptions, eloop.pollfds_map,
-					  eloop.max_pollfd_map);
+		eloop_sock_table_dispatch(&eloop->readers, &eloop->writers,
+					  &eloop->exceptions, eloop->pollfds_map,
+					  eloop->max_pollfd_map);
 #endif /* CONFIG_ELOOP_POLL */
 #ifdef CONFIG_ELOOP_SELECT
-		eloop_sock_table_dispatch(&eloop.readers, rfds);
-		eloop_sock_table_dispatch(&eloop.writers, wfds);
-		eloop_sock_table_dispatch(&eloop.exceptions, efds);
+		eloop_sock_table_dispatch(&eloop->readers, rfds);
+		eloop_sock_table_dispatch(&eloop->writers, wfds);
+		eloop_sock_table_dispatch(&eloop->exceptions, efds);
 #endif /* CONFIG_ELOOP_SELECT */
 #ifdef CONFIG_ELOOP_EPOLL
-		eloop_sock_table_dispatch(eloop.epoll_events, res);
+		eloop_sock_table_dispatch(res);
 #endif /* CONFIG_ELOOP_EPOLL */
 #ifdef CONFIG_ELOOP_KQUEUE
-		eloop_sock_table_dispatch(eloop.kqueue_events, res);
+		eloop_sock_table_dispatch(eloop->kqueue_events, res);
 #endif /* CONFIG_ELOOP_KQUEUE */
 	}
 
-	eloop.terminate = 0;
+	eloop->terminate = 0;
 out:
 #ifdef CONFIG_ELOOP_SELECT
 	os_free(rfds);
@@ -1255,7 +1591,7 @@ out:
 
 void eloop_terminate(void)
 {
-	eloop.terminate = 1;
+	eloop->terminate = 1;
 }
 
 
@@ -1264,8 +1600,12 @@ void eloop_destroy(void)
 	struct eloop_timeout *timeout, *prev;
 	struct os_reltime now;
 
+#ifdef CONFIG_ELOOP_THREADS
+	eloop_post_deinit();
+#endif /* CONFIG_ELOOP_THREADS */
+
 	os_get_reltime(&now);
-	dl_list_for_each_safe(timeout, prev, &eloop.timeout,
+	dl_list_for_each_safe(timeout, prev, &eloop->timeout,
 			      struct eloop_timeout, list) {
 		int sec, usec;
 		sec = timeout->time.sec - now.sec;
@@ -1283,32 +1623,34 @@ void eloop_destroy(void)
 		wpa_trace_dump("eloop timeout", timeout);
 		eloop_remove_timeout(timeout);
 	}
-	eloop_sock_table_destroy(&eloop.readers);
-	eloop_sock_table_destroy(&eloop.writers);
-	eloop_sock_table_destroy(&eloop.exceptions);
-	os_free(eloop.signals);
+	eloop_sock_table_destroy(&eloop->readers);
+	eloop_sock_table_destroy(&eloop->writers);
+	eloop_sock_table_destroy(&eloop->exceptions);
+	os_free(eloop->signals);
 
 #ifdef CONFIG_ELOOP_POLL
-	os_free(eloop.pollfds);
-	os_free(eloop.pollfds_map);
+	os_free(eloop->pollfds);
+	os_free(eloop->pollfds_map);
 #endif /* CONFIG_ELOOP_POLL */
 #if defined(CONFIG_ELOOP_EPOLL) || defined(CONFIG_ELOOP_KQUEUE)
-	os_free(eloop.fd_table);
+	os_free(eloop->fd_table);
 #endif /* CONFIG_ELOOP_EPOLL || CONFIG_ELOOP_KQUEUE */
 #ifdef CONFIG_ELOOP_EPOLL
-	os_free(eloop.epoll_events);
-	close(eloop.epollfd);
+	os_free(eloop->epoll_events);
+	if (eloop->timerfd >= 0)
+		close(eloop->timerfd);
+	close(eloop->epollfd);
 #endif /* CONFIG_ELOOP_EPOLL */
 #ifdef CONFIG_ELOOP_KQUEUE
-	os_free(eloop.kqueue_events);
-	close(eloop.kqueuefd);
+	os_free(eloop->kqueue_events);
+	close(eloop->kqueuefd);
 #endif /* CONFIG_ELOOP_KQUEUE */
 }
 
 
 int eloop_terminated(void)
 {
-	return eloop.terminate || eloop.pending_terminate;
+	return eloop->terminate || eloop->pending_terminate;
 }
 
 
@@ -364,4 +364,65 @@ int eloop_terminated(void);
  */
 void eloop_wait_for_read_sock(int sock);
 
+#ifdef CONFIG_ELOOP_THREADS
+
+struct eloop_data;
+
+/**
+ * eloop_instance_new - Allocate and initialize a new event loop instance
+ * Returns: Pointer to the new instance or %NULL on failure
+ *
+ * The returned instance is independent of the default event loop that is
+ * initialized with eloop_init(): it has its own sockets, timeouts, and
+ * cross-thread message queue. It is intended to be run with eloop_run() from
+ * a separate thread after selecting it with eloop_instance_set(). Signal
+ * handlers are process wide and are always delivered through the default
+ * event loop.
+ */
+struct eloop_data * eloop_instance_new(void);
+
+/**
+ * eloop_instance_free - Free an event loop instance
+ * @e: Instance from eloop_instance_new()
+ *
+ * This is the eloop_destroy() equivalent for instances allocated with
+ * eloop_instance_new(). The instance must not be running in any thread.
+ */
+void eloop_instance_free(struct eloop_data *e);
+
+/**
+ * eloop_instance_set - Select the event loop instance for the calling thread
+ * @e: Instance from eloop_instance_new() or %NULL for the default event loop
+ * Returns: The previously selected instance
+ *
+ * All other eloop_*() functions operate on the instance selected for the
+ * calling thread. Threads start out using the default event loop.
+ */
+struct eloop_data * eloop_instance_set(struct eloop_data *e);
+
+/**
+ * eloop_instance_get - Get the event loop instance of the calling thread
+ * Returns: The currently selected instance
+ */
+struct eloop_data * eloop_instance_get(void);
+
+/**
+ * eloop_instance_post - Queue a callback to be run in another event loop
+ * @e: Target instance or %NULL for the default event loop
+ * @handler: Callback function to be called from the target event loop
+ * @eloop_data: Callback context data (eloop_ctx)
+ * @user_data: Callback context data (user_ctx)
+ * Returns: 0 on success, -1 on failure
+ *
+ * This is the only eloop function that can be called for an instance that is
+ * owned by another thread. The callback is run from eloop_run() of the target
+ * instance in the order the messages were posted. Data shared between event
+ * loops should be handed over with this mechanism instead of being accessed
+ * directly from multiple threads.
+ */
+int eloop_instance_post(struct eloop_data *e, eloop_timeout_handler handler,
+			void *eloop_data, void *user_data);
+
+#endif /* CONFIG_ELOOP_THREADS */
+
 #endif /* ELOOP_H */
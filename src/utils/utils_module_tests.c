@@ -358,7 +358,7 @@ static int base64_tests(void)
 
 static int common_tests(void)
 {
-	char buf[3], longbuf[100];
+	char buf[3], longbuf[100], *context;
 	u8 addr[ETH_ALEN] = { 1, 2, 3, 4, 5, 6 };
 	u8 bin[3];
 	int errors = 0;
@@ -436,6 +436,15 @@ static int common_tests(void)
 	    os_strcmp(longbuf, "01-0") != 0)
 		errors++;
 
+	os_strlcpy(longbuf, "a\n\nbc\nd", sizeof(longbuf));
+	context = longbuf;
+	if (os_strcmp(str_line(&context), "a") != 0 ||
+	    os_strcmp(str_line(&context), "") != 0 ||
+	    os_strcmp(str_line(&context), "bc") != 0 ||
+	    os_strcmp(str_line(&context), "d") != 0 ||
+	    str_line(&context) != NULL)
+		errors++;
+
 	if (errors) {
 		wpa_printf(MSG_ERROR, "%d common test(s) failed", errors);
 		return -1;
@@ -827,8 +836,188 @@ static void eloop_tests_run(void *eloop_data, void *user_ctx)
 }
 
 
+#ifdef CONFIG_ELOOP_THREADS
+
+static void eloop_instance_test_post(void *eloop_ctx, void *user_ctx)
+{
+	int *count = eloop_ctx;
+
+	(*count)++;
+}
+
+
+static void eloop_instance_test_timeout(void *eloop_ctx, void *user_ctx)
+{
+	int *count = eloop_ctx;
+
+	(*count) += 10;
+	eloop_terminate();
+}
+
+
+static int eloop_instance_tests(void)
+{
+	struct eloop_data *e, *prev;
+	int count = 0, errors = 0;
+
+	wpa_printf(MSG_INFO, "eloop instance tests");
+
+	e = eloop_instance_new();
+	if (!e)
+		return -1;
+
+	if (eloop_instance_post(e, eloop_instance_test_post, &count, NULL) < 0)
+		errors++;
+
+	prev = eloop_instance_set(e);
+	if (eloop_instance_get() != e)
+		errors++;
+	eloop_register_timeout(0, 10000, eloop_instance_test_timeout, &count,
+			       NULL);
+	eloop_run();
+	if (eloop_instance_set(prev) != e)
+		errors++;
+
+	if (count != 11) {
+		wpa_printf(MSG_ERROR, "eloop instance test: count=%d", count);
+		errors++;
+	}
+	if (eloop_is_timeout_registered(eloop_instance_test_timeout, &count,
+					NULL))
+		errors++;
+
+	eloop_instance_free(e);
+
+	if (errors) {
+		wpa_printf(MSG_ERROR, "%d eloop instance test(s) failed",
+			   errors);
+		return -1;
+	}
+
+	return 0;
+}
+
+
+#define ELOOP_GROW_TEST_READY 4
+#define ELOOP_GROW_TEST_ADDED 32
+
+struct eloop_grow_test {
+	int ready[ELOOP_GROW_TEST_READY][2];
+	int added[ELOOP_GROW_TEST_ADDED][2];
+	int num_added;
+	int count;
+};
+
+
+static void eloop_grow_test_dummy(int sock, void *eloop_ctx, void *sock_ctx)
+{
+}
+
+
+static void eloop_grow_test_read(int sock, void *eloop_ctx, void *sock_ctx)
+{
+	struct eloop_grow_test *t = eloop_ctx;
+	char buf[1];
+	int i;
+
+	if (read(sock, buf, sizeof(buf)) < 0)
+		wpa_printf(MSG_INFO, "%s: read: %s", __func__, strerror(errno));
+	eloop_unregister_read_sock(sock);
+	t->count++;
+
+	if (t->num_added)
+		return;
+
+	/* Register enough sockets from within the handler to force the
+	 * epoll event buffer to be reallocated while the rest of the events
+	 * from the same epoll_wait() call are still to be dispatched. */
+	for (i = 0; i < ELOOP_GROW_TEST_ADDED; i++) {
+		if (pipe(t->added[i]) < 0)
+			break;
+		t->num_added++;
+		eloop_register_read_sock(t->added[i][0],
+					 eloop_grow_test_dummy, t, NULL);
+	}
+}
+
+
+static void eloop_grow_test_timeout(void *eloop_ctx, void *user_ctx)
+{
+	eloop_terminate();
+}
+
+
+static int eloop_grow_tests(void)
+{
+	struct eloop_grow_test *t;
+	struct eloop_data *e, *prev;
+	int i, num_ready = 0, errors = 0;
+
+	wpa_printf(MSG_INFO, "eloop socket registration during dispatch tests");
+
+	t = os_zalloc(sizeof(*t));
+	e = eloop_instance_new();
+	if (!t || !e) {
+		os_free(t);
+		eloop_instance_free(e);
+		return -1;
+	}
+
+	prev = eloop_instance_set(e);
+	for (i = 0; i < ELOOP_GROW_TEST_READY; i++) {
+		if (pipe(t->ready[i]) < 0)
+			break;
+		num_ready++;
+		if (write(t->ready[i][1], "x", 1) != 1 ||
+		    eloop_register_read_sock(t->ready[i][0],
+					     eloop_grow_test_read, t,
+					     NULL) < 0)
+			errors++;
+	}
+	eloop_register_timeout(0, 50000, eloop_grow_test_timeout, t, NULL);
+	eloop_run();
+	eloop_cancel_timeout(eloop_grow_test_timeout, t, NULL);
+
+	if (t->count != ELOOP_GROW_TEST_READY ||
+	    t->num_added != ELOOP_GROW_TEST_ADDED) {
+		wpa_printf(MSG_ERROR,
+			   "eloop grow test: count=%d num_added=%d",
+			   t->count, t->num_added);
+		errors++;
+	}
+
+	for (i = 0; i < t->num_added; i++) {
+		eloop_unregister_read_sock(t->added[i][0]);
+		close(t->added[i][0]);
+		close(t->added[i][1]);
+	}
+	for (i = 0; i < num_ready; i++) {
+		close(t->ready[i][0]);
+		close(t->ready[i][1]);
+	}
+	eloop_instance_set(prev);
+	eloop_instance_free(e);
+	os_free(t);
+
+	if (errors) {
+		wpa_printf(MSG_ERROR, "%d eloop grow test(s) failed", errors);
+		return -1;
+	}
+
+	return 0;
+}
+
+#endif /* CONFIG_ELOOP_THREADS */
+
+
 static int eloop_tests(void)
 {
+#ifdef CONFIG_ELOOP_THREADS
+	if (eloop_instance_tests() < 0 ||
+	    eloop_grow_tests() < 0)
+		return -1;
+#endif /* CONFIG_ELOOP_THREADS */
+
 	wpa_printf(MSG_INFO, "schedule eloop tests to be run");
 
 	/*
@@ -1209,6 +1398,51 @@ static int const_time_tests(void)
 }
 
 
+#ifdef CONFIG_DEBUG_RING
+static int debug_ring_tests(void)
+{
+	char buf[2048];
+	u8 data[4] = { 0x01, 0x23, 0x45, 0x67 };
+	int level = wpa_debug_ring_level;
+	int ret = -1;
+	int len;
+
+	wpa_printf(MSG_INFO, "debug ring tests");
+
+	wpa_debug_ring_level = MSG_EXCESSIVE;
+	wpa_printf(MSG_EXCESSIVE, "debug-ring-test %d", 12345);
+	wpa_hexdump(MSG_EXCESSIVE, "debug-ring-hexdump", data, sizeof(data));
+	wpa_hexdump_key(MSG_EXCESSIVE, "debug-ring-key", NULL, 0);
+	wpa_debug_ring_level = MSG_ERROR + 1;
+	wpa_printf(MSG_ERROR, "debug-ring-not-recorded");
+
+	len = wpa_debug_ring_dump(buf, sizeof(buf) - 1, 10);
+	buf[len] = '\0';
+	if (!os_strstr(buf, "debug-ring-test 12345\n") ||
+	    !os_strstr(buf, "debug-ring-hexdump - hexdump(len=4): 01 23 45 67") ||
+	    !os_strstr(buf, "debug-ring-key - hexdump(len=0): [NULL]") ||
+	    os_strstr(buf, "debug-ring-not-recorded")) {
+		wpa_printf(MSG_ERROR, "debug ring: Unexpected dump contents");
+		goto fail;
+	}
+
+	/* Only the newest entries are included when the buffer is short */
+	len = wpa_debug_ring_dump(buf, 100, 0);
+	buf[len] = '\0';
+	if (len == 0 || len >= 100 || os_strstr(buf, "debug-ring-test") ||
+	    !os_strstr(buf, "debug-ring-key")) {
+		wpa_printf(MSG_ERROR, "debug ring: Unexpected truncated dump");
+		goto fail;
+	}
+
+	ret = 0;
+fail:
+	wpa_debug_ring_level = level;
+	return ret;
+}
+#endif /* CONFIG_DEBUG_RING */
+
+
 int utils_module_tests(void)
 {
 	int ret = 0;
@@ -1229,6 +1463,10 @@ int utils_module_tests(void)
 	    const_time_tests() < 0 ||
 	    int_array_tests() < 0)
 		ret = -1;
+#ifdef CONFIG_DEBUG_RING
+	if (debug_ring_tests() < 0)
+		ret = -1;
+#endif /* CONFIG_DEBUG_RING */
 
 	return ret;
 }
@@ -195,6 +195,259 @@ void wpa_debug_close_linux_tracing(void)
 #endif /* CONFIG_DEBUG_LINUX_TRACING */
 
 
+#ifdef CONFIG_DEBUG_RING
+
+/*
+ * In-memory ring of recent debug messages. Entries are recorded regardless of
+ * wpa_debug_level so that the latest history can be fetched over the control
+ * interface (LOG_RING) even when debug output was not enabled. Writers claim
+ * a slot with an atomic increment and publish it by storing the sequence
+ * number last; readers copy the entry and discard it if the sequence number
+ * changed while copying.
+ */
+
+#define WPA_DEBUG_RING_ENTRIES 1024
+#define WPA_DEBUG_RING_DATA_LEN 224
+
+enum wpa_debug_ring_type {
+	WPA_DEBUG_RING_TEXT,
+	WPA_DEBUG_RING_HEXDUMP,
+	WPA_DEBUG_RING_HEXDUMP_ASCII,
+};
+
+struct wpa_debug_ring_entry {
+	unsigned int seq; /* slot index + 1 when valid, 0 while being written */
+	struct os_time time;
+	u8 type; /* enum wpa_debug_ring_type */
+	u8 level;
+	u8 title_len; /* hexdump title at the beginning of data[] */
+	u8 flags;
+	u16 data_len;
+	u32 hexdump_len; /* original length of the dumped buffer */
+	char data[WPA_DEBUG_RING_DATA_LEN];
+};
+
+#define WPA_DEBUG_RING_NULL BIT(0)
+#define WPA_DEBUG_RING_REMOVED BIT(1)
+
+int wpa_debug_ring_level = MSG_DEBUG;
+static struct wpa_debug_ring_entry wpa_debug_ring[WPA_DEBUG_RING_ENTRIES];
+static unsigned int wpa_debug_ring_head;
+
+#ifdef __GNUC__
+#define ring_fetch_inc(p) __atomic_fetch_add((p), 1, __ATOMIC_RELAXED)
+#define ring_load(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define ring_store(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define ring_fence() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#else /* __GNUC__ */
+#define ring_fetch_inc(p) ((*(p))++)
+#define ring_load(p) (*(p))
+#define ring_store(p, v) (*(p) = (v))
+#define ring_fence() do { } while (0)
+#endif /* __GNUC__ */
+
+
+static struct wpa_debug_ring_entry *
+wpa_debug_ring_claim(int level, enum wpa_debug_ring_type type,
+		     unsigned int *idx)
+{
+	struct wpa_debug_ring_entry *e;
+
+	*idx = ring_fetch_inc(&wpa_debug_ring_head);
+	e = &wpa_debug_ring[*idx % WPA_DEBUG_RING_ENTRIES];
+	ring_store(&e->seq, 0);
+	ring_fence();
+	os_get_time(&e->time);
+	e->type = type;
+	e->level = level;
+	e->title_len = 0;
+	e->flags = 0;
+	e->data_len = 0;
+	e->hexdump_len = 0;
+	return e;
+}
+
+
+static void wpa_debug_ring_vprintf(int level, const char *fmt, va_list ap)
+{
+	struct wpa_debug_ring_entry *e;
+	unsigned int idx;
+	int res;
+
+	e = wpa_debug_ring_claim(level, WPA_DEBUG_RING_TEXT, &idx);
+	res = vsnprintf(e->data, sizeof(e->data), fmt, ap);
+	if (res < 0)
+		res = 0;
+	else if ((size_t) res >= sizeof(e->data))
+		res = sizeof(e->data) - 1;
+	e->data_len = res;
+	ring_store(&e->seq, idx + 1);
+}
+
+
+static void wpa_debug_ring_hexdump(int level, const char *title,
+				   const u8 *buf, size_t len, int show,
+				   int ascii)
+{
+	struct wpa_debug_ring_entry *e;
+	unsigned int idx;
+	size_t tlen, dlen;
+
+	e = wpa_debug_ring_claim(level, ascii ? WPA_DEBUG_RING_HEXDUMP_ASCII :
+				 WPA_DEBUG_RING_HEXDUMP, &idx);
+	tlen = title ? os_strlen(title) : 0;
+	if (tlen > 64)
+		tlen = 64;
+	os_memcpy(e->data, title, tlen);
+	e->title_len = tlen;
+	e->hexdump_len = len;
+	if (!buf) {
+		e->flags |= WPA_DEBUG_RING_NULL;
+	} else if (!show) {
+		e->flags |= WPA_DEBUG_RING_REMOVED;
+	} else {
+		dlen = len;
+		if (dlen > sizeof(e->data) - tlen)
+			dlen = sizeof(e->data) - tlen;
+		os_memcpy(&e->data[tlen], buf, dlen);
+		e->data_len = dlen;
+	}
+	ring_store(&e->seq, idx + 1);
+}
+
+
+static bool wpa_debug_ring_get(unsigned int idx,
+			       struct wpa_debug_ring_entry *e)
+{
+	const struct wpa_debug_ring_entry *src;
+
+	src = &wpa_debug_ring[idx % WPA_DEBUG_RING_ENTRIES];
+	if (ring_load(&src->seq) != idx + 1)
+		return false;
+	os_memcpy(e, src, sizeof(*e));
+	ring_fence();
+	return ring_load(&src->seq) == idx + 1;
+}
+
+
+static int wpa_debug_ring_entry_txt(const struct wpa_debug_ring_entry *e,
+				    char *buf, size_t buflen)
+{
+	char *pos = buf, *end = buf + buflen;
+	const u8 *data;
+	size_t i;
+	int ret;
+
+	ret = os_snprintf(pos, end - pos, "%ld.%06u: <%d>",
+			  (long) e->time.sec, (unsigned int) e->time.usec,
+			  e->level);
+	if (os_snprintf_error(end - pos, ret))
+		return -1;
+	pos += ret;
+
+	if (e->type == WPA_DEBUG_RING_TEXT) {
+		ret = os_snprintf(pos, end - pos, "%.*s\n",
+				  (int) e->data_len, e->data);
+		if (os_snprintf_error(end - pos, ret))
+			return -1;
+		pos += ret;
+		return pos - buf;
+	}
+
+	ret = os_snprintf(pos, end - pos, "%.*s - %s(len=%lu):",
+			  (int) e->title_len, e->data,
+			  e->type == WPA_DEBUG_RING_HEXDUMP_ASCII ?
+			  "hexdump_ascii" : "hexdump",
+			  (unsigned long) e->hexdump_len);
+	if (os_snprintf_error(end - pos, ret))
+		return -1;
+	pos += ret;
+
+	if (e->flags & WPA_DEBUG_RING_NULL) {
+		ret = os_snprintf(pos, end - pos, " [NULL]");
+	} else if (e->flags & WPA_DEBUG_RING_REMOVED) {
+		ret = os_snprintf(pos, end - pos, " [REMOVED]");
+	} else {
+		data = (const u8 *) &e->data[e->title_len];
+		for (i = 0; i < e->data_len; i++) {
+			ret = os_snprintf(pos, end - pos, " %02x", data[i]);
+			if (os_snprintf_error(end - pos, ret))
+				return -1;
+			pos += ret;
+		}
+		ret = os_snprintf(pos, end - pos, "%s",
+				  e->hexdump_len > e->data_len ? " ..." : "");
+	}
+	if (os_snprintf_error(end - pos, ret))
+		return -1;
+	pos += ret;
+
+	ret = os_snprintf(pos, end - pos, "\n");
+	if (os_snprintf_error(end - pos, ret))
+		return -1;
+	pos += ret;
+
+	return pos - buf;
+}
+
+
+/**
+ * wpa_debug_ring_dump - Write recent debug messages into a buffer
+ * @buf: Buffer for the messages
+ * @buflen: Length of the buffer
+ * @max_age: Maximum age of included messages in seconds or 0 for no limit
+ * Returns: Number of bytes written to buf
+ *
+ * The newest messages that fit into the buffer are included in chronological
+ * order.
+ */
+int wpa_debug_ring_dump(char *buf, size_t buflen, unsigned int max_age)
+{
+	struct wpa_debug_ring_entry e;
+	char tmp[64 + 3 * WPA_DEBUG_RING_DATA_LEN + 64];
+	struct os_time now;
+	unsigned int head, oldest, start, i;
+	size_t total = 0;
+	char *pos = buf, *end = buf + buflen;
+	int len;
+
+	os_get_time(&now);
+	head = ring_load(&wpa_debug_ring_head);
+	oldest = head > WPA_DEBUG_RING_ENTRIES ?
+		head - WPA_DEBUG_RING_ENTRIES : 0;
+
+	/* Find the oldest entry that still fits when going back from the
+	 * newest one */
+	start = head;
+	for (i = head; i > oldest; i--) {
+		if (!wpa_debug_ring_get(i - 1, &e))
+			continue;
+		if (max_age && now.sec - e.time.sec >= (os_time_t) max_age)
+			break;
+		len = wpa_debug_ring_entry_txt(&e, tmp, sizeof(tmp));
+		if (len < 0)
+			continue;
+		if (total + len >= buflen)
+			break;
+		total += len;
+		start = i - 1;
+	}
+
+	for (i = start; i != head; i++) {
+		if (!wpa_debug_ring_get(i, &e))
+			continue;
+		len = wpa_debug_ring_entry_txt(&e, pos, end - pos);
+		if (len < 0)
+			break;
+		pos += len;
+	}
+
+	return pos - buf;
+}
+
+#endif /* CONFIG_DEBUG_RING */
+
+
 /**
  * wpa_printf - conditional printf
  * @level: priority level (MSG_*) of the message
@@ -210,6 +463,14 @@ void wpa_printf(int level, const char *fmt, ...)
 {
 	va_list ap;
 
+#ifdef CONFIG_DEBUG_RING
+	if (level >= wpa_debug_ring_level) {
+		va_start(ap, fmt);
+		wpa_debug_ring_vprintf(level, fmt, ap);
+		va_end(ap);
+	}
+#endif /* CONFIG_DEBUG_RING */
+
 	if (level >= wpa_debug_level) {
 #ifdef CONFIG_ANDROID_LOG
 		va_start(ap, fmt);
@@ -384,12 +645,21 @@ static void _wpa_hexdump(int level, const char *title, const u8 *buf,
 
 void wpa_hexdump(int level, const char *title, const void *buf, size_t len)
 {
+#ifdef CONFIG_DEBUG_RING
+	if (level >= wpa_debug_ring_level)
+		wpa_debug_ring_hexdump(level, title, buf, len, 1, 0);
+#endif /* CONFIG_DEBUG_RING */
 	_wpa_hexdump(level, title, buf, len, 1, 0);
 }
 
 
 void wpa_hexdump_key(int level, const char *title, const void *buf, size_t len)
 {
+#ifdef CONFIG_DEBUG_RING
+	if (level >= wpa_debug_ring_level)
+		wpa_debug_ring_hexdump(level, title, buf, len,
+				       wpa_debug_show_keys, 0);
+#endif /* CONFIG_DEBUG_RING */
 	_wpa_hexdump(level, title, buf, len, wpa_debug_show_keys, 0);
 }
 
@@ -401,6 +671,11 @@ static void _wpa_hexdump_ascii(int level, const char *title, const void *buf,
 	const u8 *pos = buf;
 	const size_t line_len = 16;
 
+#ifdef CONFIG_DEBUG_RING
+	if (level >= wpa_debug_ring_level)
+		wpa_debug_ring_hexdump(level, title, buf, len, show, 1);
+#endif /* CONFIG_DEBUG_RING */
+
 #ifdef CONFIG_DEBUG_LINUX_TRACING
 	if (wpa_debug_tracing_file != NULL) {
 		fprintf(wpa_debug_tracing_file,
@@ -649,193 +924,163 @@ void wpa_msg_register_ifname_cb(wpa_msg_get_ifname_func func)
 }
 
 
-void wpa_msg(void *ctx, int level, const char *fmt, ...)
+static wpa_msg_wanted_func wpa_msg_wanted_cb = NULL;
+
+void wpa_msg_register_wanted_cb(wpa_msg_wanted_func func)
 {
-	va_list ap;
-	char *buf;
-	int buflen;
-	int len;
+	wpa_msg_wanted_cb = func;
+}
+
+
+static bool wpa_msg_debug_enabled(int level)
+{
+#ifdef CONFIG_DEBUG_RING
+	if (level >= wpa_debug_ring_level)
+		return true;
+#endif /* CONFIG_DEBUG_RING */
+#ifdef CONFIG_DEBUG_LINUX_TRACING
+	if (wpa_debug_tracing_file)
+		return true;
+#endif /* CONFIG_DEBUG_LINUX_TRACING */
+#ifdef CONFIG_NO_STDOUT_DEBUG
+	return false;
+#else /* CONFIG_NO_STDOUT_DEBUG */
+	return level >= wpa_debug_level;
+#endif /* CONFIG_NO_STDOUT_DEBUG */
+}
+
+
+static bool wpa_msg_cb_wanted(void *ctx, int level, enum wpa_msg_type type)
+{
+	if (wpa_msg_aidl_cb)
+		return true;
+	if (!wpa_msg_cb)
+		return false;
+	return !wpa_msg_wanted_cb || wpa_msg_wanted_cb(ctx, level, type);
+}
+
+
+/* Most messages fit into this and can be formatted on stack with a single
+ * vsnprintf() call. */
+#define WPA_MSG_STACK_BUF_LEN 256
+
+static void wpa_msg_va(void *ctx, int level, enum wpa_msg_type type,
+		       bool print, bool ifname_prefix, const char *fmt,
+		       va_list ap)
+{
+	char stack_buf[WPA_MSG_STACK_BUF_LEN];
+	char *buf = stack_buf;
+	size_t buflen = sizeof(stack_buf);
 	char prefix[130];
+	va_list ap2;
+	int len;
 
-	va_start(ap, fmt);
-	buflen = vsnprintf(NULL, 0, fmt, ap) + 1;
-	va_end(ap);
+	/* Skip formatting completely if nobody is going to see the message */
+	print = print && wpa_msg_debug_enabled(level);
+	if (!print && !wpa_msg_cb_wanted(ctx, level, type))
+		return;
 
-	buf = os_malloc(buflen);
-	if (buf == NULL) {
-		wpa_printf(MSG_ERROR, "wpa_msg: Failed to allocate message "
-			   "buffer");
+	va_copy(ap2, ap);
+	len = vsnprintf(buf, buflen, fmt, ap2);
+	va_end(ap2);
+	if (len < 0)
 		return;
+	if ((size_t) len >= buflen) {
+		buflen = len + 1;
+		buf = os_malloc(buflen);
+		if (!buf) {
+			wpa_printf(MSG_ERROR,
+				   "wpa_msg: Failed to allocate message buffer");
+			return;
+		}
+		len = vsnprintf(buf, buflen, fmt, ap);
+		if (len < 0 || (size_t) len >= buflen)
+			goto out;
 	}
-	va_start(ap, fmt);
-	prefix[0] = '\0';
-	if (wpa_msg_ifname_cb) {
-		const char *ifname = wpa_msg_ifname_cb(ctx);
-		if (ifname) {
-			int res = os_snprintf(prefix, sizeof(prefix), "%s: ",
-					      ifname);
-			if (os_snprintf_error(sizeof(prefix), res))
-				prefix[0] = '\0';
+
+	if (print) {
+		prefix[0] = '\0';
+		if (ifname_prefix && wpa_msg_ifname_cb) {
+			const char *ifname = wpa_msg_ifname_cb(ctx);
+
+			if (ifname) {
+				int res = os_snprintf(prefix, sizeof(prefix),
+						      "%s: ", ifname);
+				if (os_snprintf_error(sizeof(prefix), res))
+					prefix[0] = '\0';
+			}
 		}
+		wpa_printf(level, "%s%s", prefix, buf);
 	}
-	len = vsnprintf(buf, buflen, fmt, ap);
-	va_end(ap);
-	wpa_printf(level, "%s%s", prefix, buf);
 	if (wpa_msg_cb)
-		wpa_msg_cb(ctx, level, WPA_MSG_PER_INTERFACE, buf, len);
+		wpa_msg_cb(ctx, level, type, buf, len);
 	if (wpa_msg_aidl_cb)
-		wpa_msg_aidl_cb(ctx, level, WPA_MSG_PER_INTERFACE, buf, len);
-	bin_clear_free(buf, buflen);
+		wpa_msg_aidl_cb(ctx, level, type, buf, len);
+
+out:
+	forced_memzero(stack_buf, sizeof(stack_buf));
+	if (buf != stack_buf)
+		bin_clear_free(buf, buflen);
 }
 
 
-void wpa_msg_ctrl(void *ctx, int level, const char *fmt, ...)
+void wpa_msg(void *ctx, int level, const char *fmt, ...)
 {
 	va_list ap;
-	char *buf;
-	int buflen;
-	int len;
-
-	if (!wpa_msg_cb && !wpa_msg_aidl_cb)
-		return;
 
 	va_start(ap, fmt);
-	buflen = vsnprintf(NULL, 0, fmt, ap) + 1;
+	wpa_msg_va(ctx, level, WPA_MSG_PER_INTERFACE, true, true, fmt, ap);
 	va_end(ap);
+}
+
+
+void wpa_msg_ctrl(void *ctx, int level, const char *fmt, ...)
+{
+	va_list ap;
 
-	buf = os_malloc(buflen);
-	if (buf == NULL) {
-		wpa_printf(MSG_ERROR, "wpa_msg_ctrl: Failed to allocate "
-			   "message buffer");
-		return;
-	}
 	va_start(ap, fmt);
-	len = vsnprintf(buf, buflen, fmt, ap);
+	wpa_msg_va(ctx, level, WPA_MSG_PER_INTERFACE, false, false, fmt, ap);
 	va_end(ap);
-	if (wpa_msg_cb)
-		wpa_msg_cb(ctx, level, WPA_MSG_PER_INTERFACE, buf, len);
-	if (wpa_msg_aidl_cb)
-		wpa_msg_aidl_cb(ctx, level, WPA_MSG_PER_INTERFACE, buf, len);
-	bin_clear_free(buf, buflen);
 }
 
 
 void wpa_msg_global(void *ctx, int level, const char *fmt, ...)
 {
 	va_list ap;
-	char *buf;
-	int buflen;
-	int len;
 
 	va_start(ap, fmt);
-	buflen = vsnprintf(NULL, 0, fmt, ap) + 1;
+	wpa_msg_va(ctx, level, WPA_MSG_GLOBAL, true, false, fmt, ap);
 	va_end(ap);
-
-	buf = os_malloc(buflen);
-	if (buf == NULL) {
-		wpa_printf(MSG_ERROR, "wpa_msg_global: Failed to allocate "
-			   "message buffer");
-		return;
-	}
-	va_start(ap, fmt);
-	len = vsnprintf(buf, buflen, fmt, ap);
-	va_end(ap);
-	wpa_printf(level, "%s", buf);
-	if (wpa_msg_cb)
-		wpa_msg_cb(ctx, level, WPA_MSG_GLOBAL, buf, len);
-	if (wpa_msg_aidl_cb)
-		wpa_msg_aidl_cb(ctx, level, WPA_MSG_GLOBAL, buf, len);
-	bin_clear_free(buf, buflen);
 }
 
 
 void wpa_msg_global_ctrl(void *ctx, int level, const char *fmt, ...)
 {
 	va_list ap;
-	char *buf;
-	int buflen;
-	int len;
 
-	if (!wpa_msg_cb && !wpa_msg_aidl_cb)
-		return;
-
-	va_start(ap, fmt);
-	buflen = vsnprintf(NULL, 0, fmt, ap) + 1;
-	va_end(ap);
-
-	buf = os_malloc(buflen);
-	if (buf == NULL) {
-		wpa_printf(MSG_ERROR,
-			   "wpa_msg_global_ctrl: Failed to allocate message buffer");
-		return;
-	}
 	va_start(ap, fmt);
-	len = vsnprintf(buf, buflen, fmt, ap);
+	wpa_msg_va(ctx, level, WPA_MSG_GLOBAL, false, false, fmt, ap);
 	va_end(ap);
-	if (wpa_msg_cb)
-		wpa_msg_cb(ctx, level, WPA_MSG_GLOBAL, buf, len);
-	if (wpa_msg_aidl_cb)
-		wpa_msg_aidl_cb(ctx, level, WPA_MSG_GLOBAL, buf, len);
-	bin_clear_free(buf, buflen);
 }
 
 
 void wpa_msg_no_global(void *ctx, int level, const char *fmt, ...)
 {
 	va_list ap;
-	char *buf;
-	int buflen;
-	int len;
 
 	va_start(ap, fmt);
-	buflen = vsnprintf(NULL, 0, fmt, ap) + 1;
+	wpa_msg_va(ctx, level, WPA_MSG_NO_GLOBAL, true, false, fmt, ap);
 	va_end(ap);
-
-	buf = os_malloc(buflen);
-	if (buf == NULL) {
-		wpa_printf(MSG_ERROR, "wpa_msg_no_global: Failed to allocate "
-			   "message buffer");
-		return;
-	}
-	va_start(ap, fmt);
-	len = vsnprintf(buf, buflen, fmt, ap);
-	va_end(ap);
-	wpa_printf(level, "%s", buf);
-	if (wpa_msg_cb)
-		wpa_msg_cb(ctx, level, WPA_MSG_NO_GLOBAL, buf, len);
-	if (wpa_msg_aidl_cb)
-		wpa_msg_aidl_cb(ctx, level, WPA_MSG_NO_GLOBAL, buf, len);
-
-	bin_clear_free(buf, buflen);
 }
 
 
 void wpa_msg_global_only(void *ctx, int level, const char *fmt, ...)
 {
 	va_list ap;
-	char *buf;
-	int buflen;
-	int len;
 
 	va_start(ap, fmt);
-	buflen = vsnprintf(NULL, 0, fmt, ap) + 1;
+	wpa_msg_va(ctx, level, WPA_MSG_ONLY_GLOBAL, true, false, fmt, ap);
 	va_end(ap);
-
-	buf = os_malloc(buflen);
-	if (buf == NULL) {
-		wpa_printf(MSG_ERROR, "%s: Failed to allocate message buffer",
-			   __func__);
-		return;
-	}
-	va_start(ap, fmt);
-	len = vsnprintf(buf, buflen, fmt, ap);
-	va_end(ap);
-	wpa_printf(level, "%s", buf);
-	if (wpa_msg_cb)
-		wpa_msg_cb(ctx, level, WPA_MSG_ONLY_GLOBAL, buf, len);
-	if (wpa_msg_aidl_cb)
-		wpa_msg_aidl_cb(ctx, level, WPA_MSG_ONLY_GLOBAL, buf, len);
-	os_free(buf);
 }
 
 #endif /* CONFIG_NO_WPA_MSG */
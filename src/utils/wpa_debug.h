@@ -158,6 +158,14 @@ void wpa_hexdump_ascii_key(int level, const char *title, const void *buf,
  */
 #define wpa_dbg(args...) wpa_msg(args)
 
+#ifdef CONFIG_DEBUG_RING
+/* Minimum level of messages recorded into the debug ring buffer; levels above
+ * MSG_ERROR disable recording */
+extern int wpa_debug_ring_level;
+
+int wpa_debug_ring_dump(char *buf, size_t buflen, unsigned int max_age);
+#endif /* CONFIG_DEBUG_RING */
+
 #endif /* CONFIG_NO_STDOUT_DEBUG */
 
 
@@ -171,6 +179,7 @@ void wpa_hexdump_ascii_key(int level, const char *title, const void *buf,
 #define wpa_msg_register_cb(f) do { } while (0)
 #define wpa_msg_register_aidl_cb(f) do { } while (0)
 #define wpa_msg_register_ifname_cb(f) do { } while (0)
+#define wpa_msg_register_wanted_cb(f) do { } while (0)
 #else /* CONFIG_NO_WPA_MSG */
 /**
  * wpa_msg - Conditional printf for default target and ctrl_iface monitors
@@ -281,6 +290,20 @@ void wpa_msg_register_aidl_cb(wpa_msg_cb_func func);
 typedef const char * (*wpa_msg_get_ifname_func)(void *ctx);
 void wpa_msg_register_ifname_cb(wpa_msg_get_ifname_func func);
 
+typedef int (*wpa_msg_wanted_func)(void *ctx, int level,
+				   enum wpa_msg_type type);
+
+/**
+ * wpa_msg_register_wanted_cb - Register callback for checking event listeners
+ * @func: Callback function (%NULL to unregister)
+ *
+ * The callback function is used to check whether the wpa_msg_cb_func callback
+ * has any use for a message with the specified level and type. If it does
+ * not and the message is not going to be printed to debug output either, the
+ * message is not formatted at all.
+ */
+void wpa_msg_register_wanted_cb(wpa_msg_wanted_func func);
+
 #endif /* CONFIG_NO_WPA_MSG */
 
 #ifdef CONFIG_NO_HOSTAPD_LOGGER
@@ -358,6 +358,29 @@ bad:
 }
 
 
+/* httpread_body_room -- make room for len more octets of body data plus
+ * the null termination character
+ * Returns 0 on success, -1 if the buffer cannot be grown within max_bytes.
+ */
+static int httpread_body_room(struct httpread *h, int len)
+{
+	int need = h->body_nbytes + len + 1;
+	char *new_body;
+
+	if (h->body_alloc_nbytes >= need)
+		return 0;
+	if (h->body_nbytes >= h->max_bytes ||
+	    need > h->max_bytes + HTTPREAD_BODYBUF_DELTA)
+		return -1;
+	new_body = os_realloc(h->body, need);
+	if (!new_body)
+		return -1;
+	h->body = new_body;
+	h->body_alloc_nbytes = need;
+	return 0;
+}
+
+
 /* httpread_read_handler -- called when socket ready to read
  *
  * Note: any extra data we read past end of transmitted file is ignored;
@@ -377,6 +400,61 @@ static void httpread_read_handler(int sd, void *eloop_ctx, void *sock_ctx)
 	 * boundaries between header and data and etc.
 	 */
 	wpa_printf(MSG_DEBUG, "httpread: Trying to read more data(%p)", h);
+
+	if (h->got_hdr && !h->got_body && !h->chunked &&
+	    h->got_content_length && h->body &&
+	    h->body_alloc_nbytes > h->content_length) {
+		/* The body buffer has already been allocated for the full
+		 * Content-Length, so read the remaining data directly into it
+		 * without going through the temporary read buffer. */
+		nread = read(h->sd, h->body + h->body_nbytes,
+			     h->content_length - h->body_nbytes);
+		if (nread < 0) {
+			wpa_printf(MSG_DEBUG, "httpread failed: %s",
+				   strerror(errno));
+			goto bad;
+		}
+		if (nread == 0) {
+			wpa_printf(MSG_DEBUG,
+				   "httpread premature eof(%p) %d/%d",
+				   h, h->body_nbytes, h->content_length);
+			goto bad;
+		}
+		wpa_hexdump_ascii(MSG_MSGDUMP, "httpread - read",
+				  h->body + h->body_nbytes, nread);
+		h->body_nbytes += nread;
+		if (h->body_nbytes < h->content_length)
+			goto get_more;
+		h->got_body = 1;
+		wpa_printf(MSG_DEBUG, "httpread got content(%p)", h);
+		goto got_file;
+	}
+
+	if (h->got_hdr && !h->got_body && h->chunked && h->in_chunk_data &&
+	    h->chunk_start + h->chunk_size > h->body_nbytes &&
+	    httpread_body_room(h, h->chunk_start + h->chunk_size -
+			       h->body_nbytes) == 0) {
+		/* Read the rest of the chunk data directly into the body
+		 * buffer. The CRLF ending the chunk and the following chunk
+		 * header are processed through the temporary read buffer. */
+		nread = read(h->sd, h->body + h->body_nbytes,
+			     h->chunk_start + h->chunk_size - h->body_nbytes);
+		if (nread < 0) {
+			wpa_printf(MSG_DEBUG, "httpread failed: %s",
+				   strerror(errno));
+			goto bad;
+		}
+		if (nread == 0) {
+			wpa_printf(MSG_DEBUG,
+				   "httpread premature eof in chunk(%p)", h);
+			goto bad;
+		}
+		wpa_hexdump_ascii(MSG_MSGDUMP, "httpread - read",
+				  h->body + h->body_nbytes, nread);
+		h->body_nbytes += nread;
+		goto get_more;
+	}
+
 	nread = read(h->sd, readbuf, sizeof(readbuf));
 	if (nread < 0) {
 		wpa_printf(MSG_DEBUG, "httpread failed: %s", strerror(errno));
@@ -415,33 +493,44 @@ static void httpread_read_handler(int sd, void *eloop_ctx, void *sock_ctx)
 	 * and an empty line (CR LF only).
 	 */
 	if (!h->got_hdr) {
-		hbp = h->hdr + h->hdr_nbytes;
+		int ncopy, start, i;
+
 		/* add to headers until:
 		 *      -- we run out of data in read buffer
 		 *      -- or, we run out of header buffer room
 		 *      -- or, we get double CRLF in headers
+		 * The new data is copied in one go and only the new part
+		 * (plus the last three octets of the old part) is searched
+		 * for the end of the header.
 		 */
-		for (;;) {
-			if (nread == 0)
-				goto get_more;
-			if (h->hdr_nbytes == HTTPREAD_HEADER_MAX_SIZE) {
+		ncopy = HTTPREAD_HEADER_MAX_SIZE - h->hdr_nbytes;
+		if (ncopy > nread)
+			ncopy = nread;
+		hbp = h->hdr + h->hdr_nbytes;
+		os_memcpy(hbp, rbp, ncopy);
+		start = h->hdr_nbytes > 3 ? h->hdr_nbytes - 3 : 0;
+		for (i = start; i + 4 <= h->hdr_nbytes + ncopy; i++) {
+			if (h->hdr[i] == '\r' && h->hdr[i + 1] == '\n' &&
+			    h->hdr[i + 2] == '\r' && h->hdr[i + 3] == '\n') {
+				h->got_hdr = 1;
+				break;
+			}
+		}
+		if (!h->got_hdr) {
+			h->hdr_nbytes += ncopy;
+			if (ncopy < nread ||
+			    h->hdr_nbytes == HTTPREAD_HEADER_MAX_SIZE) {
 				wpa_printf(MSG_DEBUG,
 					   "httpread: Too long header");
 				goto bad;
 			}
-			*hbp++ = *rbp++;
-			nread--;
-			h->hdr_nbytes++;
-			if (h->hdr_nbytes >= 4 &&
-			    hbp[-1] == '\n' &&
-			    hbp[-2] == '\r' &&
-			    hbp[-3] == '\n' &&
-			    hbp[-4] == '\r' ) {
-				h->got_hdr = 1;
-				*hbp = 0;       /* null terminate */
-				break;
-			}
+			goto get_more;
 		}
+		ncopy = i + 4 - h->hdr_nbytes;
+		h->hdr_nbytes += ncopy;
+		h->hdr[h->hdr_nbytes] = 0;       /* null terminate */
+		rbp += ncopy;
+		nread -= ncopy;
 		/* here we've just finished reading the header */
 		if (httpread_hdr_analyze(h)) {
 			wpa_printf(MSG_DEBUG, "httpread bad hdr(%p)", h);
@@ -494,8 +583,17 @@ static void httpread_read_handler(int sd, void *eloop_ctx, void *sock_ctx)
 					   h->body_nbytes, h->max_bytes);
 				goto bad;
 			}
-			new_alloc_nbytes = h->body_alloc_nbytes +
-				HTTPREAD_BODYBUF_DELTA;
+			/* Grow the buffer geometrically to avoid repeated
+			 * reallocation and copying of large bodies. */
+			if (h->body_alloc_nbytes >
+			    (h->max_bytes + HTTPREAD_BODYBUF_DELTA) / 2)
+				new_alloc_nbytes = h->max_bytes +
+					HTTPREAD_BODYBUF_DELTA;
+			else if (h->body_alloc_nbytes > HTTPREAD_BODYBUF_DELTA)
+				new_alloc_nbytes = 2 * h->body_alloc_nbytes;
+			else
+				new_alloc_nbytes = h->body_alloc_nbytes +
+					HTTPREAD_BODYBUF_DELTA;
 			/* For content-length case, the first time
 			 * through we allocate the whole amount
 			 * we need.
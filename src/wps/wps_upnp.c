@@ -482,6 +482,7 @@ static void upnp_wps_device_send_event(struct upnp_wps_device_sm *sm)
 {
 	/* Enqueue event message for all subscribers */
 	struct wpabuf *buf; /* holds event message */
+	struct wps_event_body *body;
 	int buf_size = 0;
 	struct subscription *s, *tmp;
 	/* Actually, utf-8 is the default, but it doesn't hurt to specify it */
@@ -538,14 +539,18 @@ static void upnp_wps_device_send_event(struct upnp_wps_device_sm *sm)
 	wpa_printf(MSG_MSGDUMP, "WPS UPnP: WLANEvent message:\n%s",
 		   (char *) wpabuf_head(buf));
 
+	body = wps_upnp_event_body_new(buf);
+	if (!body)
+		return;
+
 	dl_list_for_each_safe(s, tmp, &sm->subscriptions, struct subscription,
 			      list) {
 		wps_upnp_event_add(
-			s, buf,
+			s, body,
 			sm->wlanevent_type == UPNP_WPS_WLANEVENT_TYPE_PROBE);
 	}
 
-	wpabuf_free(buf);
+	wps_upnp_event_body_unref(body);
 }
 
 
@@ -646,6 +651,7 @@ static int subscription_first_event(struct subscription *s)
 	 */
 	char *wlan_event;
 	struct wpabuf *buf;
+	struct wps_event_body *body;
 	int ap_status = 1;      /* TODO: add 0x10 if access point is locked */
 	const char *head =
 		"<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
@@ -694,14 +700,13 @@ static int subscription_first_event(struct subscription *s)
 		wpabuf_put_property(buf, "WLANEvent", wlan_event);
 	wpabuf_put_str(buf, tail);
 
-	ret = wps_upnp_event_add(s, buf, 0);
-	if (ret) {
-		wpabuf_free(buf);
-		return ret;
-	}
-	wpabuf_free(buf);
+	body = wps_upnp_event_body_new(buf);
+	if (!body)
+		return -1;
+	ret = wps_upnp_event_add(s, body, 0);
+	wps_upnp_event_body_unref(body);
 
-	return 0;
+	return ret;
 }
 
 
@@ -22,9 +22,8 @@
 /*
  * Event message generation (to subscribers)
  *
- * We make a separate copy for each message for each subscriber. This memory
- * wasted could be limited (adding code complexity) by sharing copies, keeping
- * a usage count and freeing when zero.
+ * The event body is generated once and shared between the event entries
+ * queued for each subscriber; it is freed when the last reference is dropped.
  *
  * Sending a message requires using a HTTP over TCP NOTIFY
  * (like a PUT) which requires a number of states..
@@ -37,13 +36,17 @@
 #define EVENT_DELAY_SECONDS 0
 #define EVENT_DELAY_MSEC 0
 
+/* Event body shared between the subscribers the event is queued for */
+struct wps_event_body {
+	unsigned int refcount;
+	struct wpabuf *buf;
+};
+
 /*
  * Event information that we send to each subscriber is remembered in this
  * struct. The event cannot be sent by simple UDP; it has to be sent by a HTTP
  * over TCP transaction which requires various states.. It may also need to be
  * retried at a different address (if more than one is available).
- *
- * TODO: As an optimization we could share data between subscribers.
  */
 struct wps_event_ {
 	struct dl_list list;
@@ -51,11 +54,46 @@ struct wps_event_ {
 	unsigned subscriber_sequence;   /* which event for this subscription*/
 	unsigned int retry;             /* which retry */
 	struct subscr_addr *addr;       /* address to connect to */
-	struct wpabuf *data;            /* event data to send */
+	struct wps_event_body *data;    /* event data to send (shared) */
 	struct http_client *http_event;
 };
 
 
+/**
+ * wps_upnp_event_body_new - Allocate shared event body
+ * @buf: Event body; ownership is transferred (freed on failure)
+ * Returns: Event body with one reference or %NULL on failure
+ */
+struct wps_event_body * wps_upnp_event_body_new(struct wpabuf *buf)
+{
+	struct wps_event_body *body;
+
+	if (!buf)
+		return NULL;
+	body = os_zalloc(sizeof(*body));
+	if (!body) {
+		wpabuf_free(buf);
+		return NULL;
+	}
+	body->refcount = 1;
+	body->buf = buf;
+	return body;
+}
+
+
+/**
+ * wps_upnp_event_body_unref - Drop a reference to shared event body
+ * @body: Event body from wps_upnp_event_body_new() or %NULL
+ */
+void wps_upnp_event_body_unref(struct wps_event_body *body)
+{
+	if (!body || --body->refcount > 0)
+		return;
+	wpabuf_free(body->buf);
+	os_free(body);
+}
+
+
 /* event_clean -- clean sockets etc. of event
  * Leaves data, retry count etc. alone.
  */
@@ -75,7 +113,7 @@ static void event_delete(struct wps_event_ *e)
 {
 	wpa_printf(MSG_DEBUG, "WPS UPnP: Delete event %p", e);
 	event_clean(e);
-	wpabuf_free(e->data);
+	wps_upnp_event_body_unref(e->data);
 	os_free(e);
 }
 
@@ -148,7 +186,7 @@ static struct wpabuf * event_build_message(struct wps_event_ *e)
 	char *b;
 
 	buf = wpabuf_alloc(1000 + os_strlen(e->addr->path) +
-			   wpabuf_len(e->data));
+			   wpabuf_len(e->data->buf));
 	if (buf == NULL)
 		return NULL;
 	wpabuf_printf(buf, "NOTIFY %s HTTP/1.1\r\n", e->addr->path);
@@ -164,9 +202,9 @@ static struct wpabuf * event_build_message(struct wps_event_ *e)
 	wpabuf_put_str(buf, "\r\n");
 	wpabuf_printf(buf, "SEQ: %u\r\n", e->subscriber_sequence);
 	wpabuf_printf(buf, "CONTENT-LENGTH: %d\r\n",
-		      (int) wpabuf_len(e->data));
+		      (int) wpabuf_len(e->data->buf));
 	wpabuf_put_str(buf, "\r\n"); /* terminating empty line */
-	wpabuf_put_buf(buf, e->data);
+	wpabuf_put_buf(buf, e->data->buf);
 	return buf;
 }
 
@@ -367,11 +405,11 @@ void wps_upnp_event_send_stop_all(struct upnp_wps_device_sm *sm)
 /**
  * wps_upnp_event_add - Add a new event to a queue
  * @s: Subscription
- * @data: Event data (is copied; caller retains ownership)
+ * @data: Event data (a reference is taken; caller retains its own reference)
  * @probereq: Whether this is a Probe Request event
  * Returns: 0 on success, -1 on error, 1 on max event queue limit reached
  */
-int wps_upnp_event_add(struct subscription *s, const struct wpabuf *data,
+int wps_upnp_event_add(struct subscription *s, struct wps_event_body *data,
 		       int probereq)
 {
 	struct wps_event_ *e;
@@ -407,11 +445,8 @@ int wps_upnp_event_add(struct subscription *s, const struct wpabuf *data,
 		return -1;
 	dl_list_init(&e->list);
 	e->s = s;
-	e->data = wpabuf_dup(data);
-	if (e->data == NULL) {
-		os_free(e);
-		return -1;
-	}
+	e->data = data;
+	data->refcount++;
 	e->subscriber_sequence = s->next_subscriber_sequence++;
 	if (s->next_subscriber_sequence == 0)
 		s->next_subscriber_sequence++;
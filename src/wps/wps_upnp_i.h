@@ -178,7 +178,9 @@ int web_listener_start(struct upnp_wps_device_sm *sm);
 void web_listener_stop(struct upnp_wps_device_sm *sm);
 
 /* wps_upnp_event.c */
-int wps_upnp_event_add(struct subscription *s, const struct wpabuf *data,
+struct wps_event_body * wps_upnp_event_body_new(struct wpabuf *buf);
+void wps_upnp_event_body_unref(struct wps_event_body *data);
+int wps_upnp_event_add(struct subscription *s, struct wps_event_body *data,
 		       int probereq);
 void wps_upnp_event_delete_all(struct subscription *s);
 void wps_upnp_event_send_all_later(struct upnp_wps_device_sm *sm);
@@ -202,6 +202,12 @@ ifdef CONFIG_ELOOP_EPOLL
 L_CFLAGS += -DCONFIG_ELOOP_EPOLL
 endif
 
+ifdef CONFIG_ELOOP_THREADS
+L_CFLAGS += -DCONFIG_ELOOP_THREADS
+LIBS += -lpthread
+LIBS_c += -lpthread
+endif
+
 ifdef CONFIG_EAPOL_TEST
 L_CFLAGS += -Werror -DEAPOL_TEST
 endif
@@ -1640,6 +1646,10 @@ ifdef CONFIG_IPV6
 L_CFLAGS += -DCONFIG_IPV6
 endif
 
+ifdef CONFIG_L2_PACKET_RING
+L_CFLAGS += -DCONFIG_L2_PACKET_RING
+endif
+
 ifdef NEED_BASE64
 OBJS += src/utils/base64.c
 endif
@@ -1675,6 +1685,12 @@ ifdef CONFIG_DEBUG_FILE
 L_CFLAGS += -DCONFIG_DEBUG_FILE
 endif
 
+ifdef CONFIG_DEBUG_RING
+ifndef CONFIG_NO_STDOUT_DEBUG
+L_CFLAGS += -DCONFIG_DEBUG_RING
+endif
+endif
+
 ifdef CONFIG_DELAYED_MIC_ERROR_REPORT
 L_CFLAGS += -DCONFIG_DELAYED_MIC_ERROR_REPORT
 endif
@@ -20,6 +20,7 @@
 #include "scan.h"
 #include "bssid_ignore.h"
 #include "bss.h"
+#include "interworking.h"
 
 static void wpa_bss_set_hessid(struct wpa_bss *bss)
 {
@@ -155,6 +156,7 @@ static void wpa_bss_anqp_free(struct wpa_bss_anqp *anqp)
 	wpabuf_free(anqp->network_auth_type);
 	wpabuf_free(anqp->roaming_consortium);
 	wpabuf_free(anqp->ip_addr_type_availability);
+	interworking_nai_realm_flush(anqp);
 	wpabuf_free(anqp->nai_realm);
 	wpabuf_free(anqp->anqp_3gpp);
 	wpabuf_free(anqp->domain_name);
@@ -248,10 +250,13 @@ void wpa_bss_remove(struct wpa_supplicant *wpa_s, struct wpa_bss *bss,
 	}
 
 #ifdef CONFIG_INTERWORKING
-	if (wpa_s->interworking_gas_bss == bss) {
+	for (j = 0; j < INTERWORKING_MAX_ANQP_PENDING; j++) {
+		if (wpa_s->interworking_gas_bss[j] != bss)
+			continue;
 		wpa_printf(MSG_DEBUG,
-			   "BSS: Clear interworking_gas_bss due to bss removal");
-		wpa_s->interworking_gas_bss = NULL;
+			   "BSS: Clear interworking_gas_bss[%u] due to bss removal",
+			   j);
+		wpa_s->interworking_gas_bss[j] = NULL;
 	}
 #endif /* CONFIG_INTERWORKING */
 
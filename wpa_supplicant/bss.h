@@ -10,6 +10,7 @@
 #define BSS_H
 
 struct wpa_scan_res;
+struct nai_realm;
 
 #define WPA_BSS_QUAL_INVALID		BIT(0)
 #define WPA_BSS_NOISE_INVALID		BIT(1)
@@ -50,6 +51,9 @@ struct wpa_bss_anqp {
 	struct wpabuf *roaming_consortium;
 	struct wpabuf *ip_addr_type_availability;
 	struct wpabuf *nai_realm;
+	/** Parsed nai_realm; see interworking_nai_realm_flush() */
+	struct nai_realm *nai_realm_parsed;
+	u16 nai_realm_count;
 	struct wpabuf *anqp_3gpp;
 	struct wpabuf *domain_name;
 	struct wpabuf *fils_realm_info;
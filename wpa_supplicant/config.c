@@ -4736,6 +4736,7 @@ struct wpa_config * wpa_config_alloc_empty(const char *ctrl_interface,
 	config->tx_queue[2] = txq_be;
 	config->tx_queue[3] = txq_bk;
 	config->p2p_search_delay = DEFAULT_P2P_SEARCH_DELAY;
+	config->p2p_max_peers = DEFAULT_P2P_MAX_PEERS;
 	config->rand_addr_lifetime = DEFAULT_RAND_ADDR_LIFETIME;
 	config->key_mgmt_offload = DEFAULT_KEY_MGMT_OFFLOAD;
 	config->cert_in_cb = DEFAULT_CERT_IN_CB;
@@ -5659,6 +5660,7 @@ static const struct global_parse_data global_fields[] = {
 	{ INT(tdls_external_control), 0},
 	{ STR(wowlan_triggers), CFG_CHANGED_WOWLAN_TRIGGERS },
 	{ INT(p2p_search_delay), 0},
+	{ INT_RANGE(p2p_max_peers, 1, 10000), CFG_CHANGED_P2P_MAX_PEERS },
 	{ INT_RANGE(mac_addr, 0, 2), 0 },
 	{ INT(rand_addr_lifetime), 0 },
 	{ INT_RANGE(preassoc_mac_addr, 0, 2), 0 },
@@ -37,6 +37,7 @@
 #define DEFAULT_ACCESS_NETWORK_TYPE 15
 #define DEFAULT_SCAN_CUR_FREQ 0
 #define DEFAULT_P2P_SEARCH_DELAY 500
+#define DEFAULT_P2P_MAX_PEERS 100
 #define DEFAULT_RAND_ADDR_LIFETIME 60
 #define DEFAULT_KEY_MGMT_OFFLOAD 1
 #define DEFAULT_CERT_IN_CB 1
@@ -495,6 +496,7 @@ struct wpa_dev_ik {
 #define CFG_CHANGED_BGSCAN BIT(20)
 #define CFG_CHANGED_FT_PREPEND_PMKID BIT(21)
 #define CFG_CHANGED_DISABLE_BTM_NOTIFY BIT(22)
+#define CFG_CHANGED_P2P_MAX_PEERS BIT(23)
 
 /**
  * struct wpa_config - wpa_supplicant configuration data
@@ -1466,6 +1468,16 @@ struct wpa_config {
 	 */
 	unsigned int p2p_search_delay;
 
+	/**
+	 * p2p_max_peers - Maximum number of P2P peer entries
+	 *
+	 * When this limit is reached, the least recently seen peer entry is
+	 * removed to make room for a new peer. If the limit is lowered at
+	 * runtime, the excess entries are removed the next time a new peer is
+	 * discovered.
+	 */
+	unsigned int p2p_max_peers;
+
 	/**
 	 * mac_addr - MAC address policy default
 	 *
@@ -1614,6 +1614,9 @@ static void wpa_config_write_global(FILE *f, struct wpa_config *config)
 		fprintf(f, "p2p_search_delay=%u\n",
 			config->p2p_search_delay);
 
+	if (config->p2p_max_peers != DEFAULT_P2P_MAX_PEERS)
+		fprintf(f, "p2p_max_peers=%u\n", config->p2p_max_peers);
+
 	if (config->mac_addr)
 		fprintf(f, "mac_addr=%d\n", config->mac_addr);
 
@@ -2775,6 +2775,39 @@ static int wpa_supplicant_ctrl_iface_log_level(struct wpa_supplicant *wpa_s,
 }
 
 
+#ifdef CONFIG_DEBUG_RING
+static int wpa_supplicant_ctrl_iface_log_ring_level(char *cmd, char *buf,
+						    size_t buflen)
+{
+	int ret, level;
+
+	/* cmd: "LOG_RING_LEVEL [<level>|OFF]" */
+	while (*cmd == ' ')
+		cmd++;
+	if (*cmd == '\0') {
+		ret = os_snprintf(buf, buflen, "%s\n",
+				  wpa_debug_ring_level > MSG_ERROR ? "OFF" :
+				  debug_level_str(wpa_debug_ring_level));
+		if (os_snprintf_error(buflen, ret))
+			ret = 0;
+		return ret;
+	}
+
+	if (os_strcasecmp(cmd, "OFF") == 0) {
+		level = MSG_ERROR + 1;
+	} else {
+		level = str_to_debug_level(cmd);
+		if (level < 0)
+			return -1;
+	}
+	wpa_debug_ring_level = level;
+
+	os_memcpy(buf, "OK\n", 3);
+	return 3;
+}
+#endif /* CONFIG_DEBUG_RING */
+
+
 static int wpa_supplicant_ctrl_iface_list_networks(
 	struct wpa_supplicant *wpa_s, char *cmd, char *buf, size_t buflen)
 {
@@ -5945,6 +5978,71 @@ static int wpa_supplicant_ctrl_iface_bss(struct wpa_supplicant *wpa_s,
 }
 
 
+/* BSS_DUMP [ID=<first id>] [MASK=<mask>]
+ * Print as many BSS entries as fit into the reply, starting from the first
+ * entry with an id >= the specified id. The entries are delimited with "===="
+ * and the last line is "####" if the dump reached the end of the BSS table.
+ * Otherwise, the dump can be continued from the last included id + 1.
+ * "FAIL" is returned if not even a single entry fits into the reply. */
+static int wpas_ctrl_iface_bss_dump(struct wpa_supplicant *wpa_s,
+				    const char *cmd, char *buf, size_t buflen)
+{
+	struct wpa_bss *bss;
+	unsigned long mask = WPA_BSS_MASK_ALL;
+	unsigned int first_id = 0;
+	const char *pos;
+	char *end = buf + buflen;
+	int len, ret = 0;
+	bool more = false;
+
+	pos = os_strstr(cmd, "ID=");
+	if (pos)
+		first_id = atoi(pos + 3);
+	pos = os_strstr(cmd, "MASK=");
+	if (pos) {
+		mask = strtoul(pos + 5, NULL, 0x10);
+		if (mask == 0)
+			mask = WPA_BSS_MASK_ALL;
+	}
+	mask |= WPA_BSS_MASK_ID | WPA_BSS_MASK_DELIM;
+
+	dl_list_for_each(bss, &wpa_s->bss_id, struct wpa_bss, list_id) {
+		if (bss->id < first_id)
+			continue;
+		len = print_bss_info(wpa_s, bss, mask, buf + ret,
+				     buflen - ret);
+		if (len == 0) {
+			more = true;
+			break;
+		}
+		ret += len;
+	}
+
+	if (more) {
+		/* Fail if not even the first entry fits into the reply buffer
+		 * since the client could not make any progress */
+		if (ret == 0) {
+			ret = os_snprintf(buf, buflen, "FAIL\n");
+			if (os_snprintf_error(buflen, ret))
+				return 0;
+		}
+		return ret;
+	}
+
+	/* Mark the end of the table */
+	if (ret >= 5) {
+		os_memcpy(buf + ret - 5, "####\n", 5);
+	} else {
+		len = os_snprintf(buf, end - buf, "####\n");
+		if (os_snprintf_error(end - buf, len))
+			return 0;
+		ret = len;
+	}
+
+	return ret;
+}
+
+
 static int wpa_supplicant_ctrl_iface_ap_scan(
 	struct wpa_supplicant *wpa_s, char *cmd)
 {
@@ -9031,6 +9129,9 @@ static void wpa_supplicant_ctrl_iface_flush(struct wpa_supplicant *wpa_s)
 	wpa_sm_set_param(wpa_s->wpa, RSNA_SA_TIMEOUT, 60);
 	eapol_sm_notify_logoff(wpa_s->eapol, false);
 
+#ifdef CONFIG_INTERWORKING
+	interworking_stop_fetch_anqp(wpa_s);
+#endif /* CONFIG_INTERWORKING */
 	radio_remove_works(wpa_s, NULL, 1);
 	wpa_s->ext_work_in_progress = 0;
 
@@ -11283,6 +11384,8 @@ int wpas_ctrl_cmd_debug_level(const char *cmd)
 {
 	if (os_strcmp(cmd, "PING") == 0 ||
 	    os_strncmp(cmd, "BSS ", 4) == 0 ||
+	    os_strcmp(cmd, "BSS_DUMP") == 0 ||
+	    os_strncmp(cmd, "BSS_DUMP ", 9) == 0 ||
 	    os_strncmp(cmd, "GET_NETWORK ", 12) == 0 ||
 	    os_strncmp(cmd, "STATUS", 6) == 0 ||
 	    os_strncmp(cmd, "STA ", 4) == 0 ||
@@ -12793,12 +12896,102 @@ static int wpas_ctrl_nan_unpause_publish(struct wpa_supplicant *wpa_s,
 #endif /* CONFIG_NAN_USD */
 
 
+static int wpas_ctrl_fast_scan_results(struct wpa_supplicant *wpa_s,
+				       const char *params,
+				       char *reply, size_t reply_size)
+{
+	return wpa_supplicant_ctrl_iface_scan_results(wpa_s, reply,
+						      reply_size);
+}
+
+
+static int wpas_ctrl_fast_signal_poll(struct wpa_supplicant *wpa_s,
+				      const char *params,
+				      char *reply, size_t reply_size)
+{
+	return wpa_supplicant_signal_poll(wpa_s, reply, reply_size);
+}
+
+
+static int wpas_ctrl_fast_pktcnt_poll(struct wpa_supplicant *wpa_s,
+				      const char *params,
+				      char *reply, size_t reply_size)
+{
+	return wpa_supplicant_pktcnt_poll(wpa_s, reply, reply_size);
+}
+
+
+#ifdef CONFIG_AP
+static int wpas_ctrl_fast_sta_first(struct wpa_supplicant *wpa_s,
+				    const char *params,
+				    char *reply, size_t reply_size)
+{
+	return ap_ctrl_iface_sta_first(wpa_s, reply, reply_size);
+}
+#endif /* CONFIG_AP */
+
+
+/*
+ * Frequently polled, read-only commands that are looked up before going
+ * through the full command if-else chain in
+ * wpa_supplicant_ctrl_iface_process(). The handler is called with the part of
+ * the command following the matched verb. None of these verbs can match any
+ * of the commands in the chain, so the order of the lookup does not change
+ * the behavior.
+ */
+struct wpas_ctrl_fast_cmd {
+	const char *verb;
+	size_t len;
+	bool prefix; /* allow parameters to follow the verb */
+	int (*handler)(struct wpa_supplicant *wpa_s, const char *params,
+		       char *reply, size_t reply_size);
+};
+
+#define WPAS_CTRL_FAST_CMD(verb, prefix, handler) \
+	{ (verb), sizeof(verb) - 1, (prefix), (handler) }
+
+static const struct wpas_ctrl_fast_cmd wpas_ctrl_fast_cmds[] = {
+	WPAS_CTRL_FAST_CMD("STATUS", true, wpa_supplicant_ctrl_iface_status),
+	WPAS_CTRL_FAST_CMD("SIGNAL_POLL", true, wpas_ctrl_fast_signal_poll),
+	WPAS_CTRL_FAST_CMD("PKTCNT_POLL", true, wpas_ctrl_fast_pktcnt_poll),
+	WPAS_CTRL_FAST_CMD("BSS ", true, wpa_supplicant_ctrl_iface_bss),
+	WPAS_CTRL_FAST_CMD("BSS_DUMP", false, wpas_ctrl_iface_bss_dump),
+	WPAS_CTRL_FAST_CMD("BSS_DUMP ", true, wpas_ctrl_iface_bss_dump),
+	WPAS_CTRL_FAST_CMD("SCAN_RESULTS", false, wpas_ctrl_fast_scan_results),
+#ifdef CONFIG_AP
+	WPAS_CTRL_FAST_CMD("STA ", true, ap_ctrl_iface_sta),
+	WPAS_CTRL_FAST_CMD("STA-FIRST", false, wpas_ctrl_fast_sta_first),
+	WPAS_CTRL_FAST_CMD("STA-NEXT ", true, ap_ctrl_iface_sta_next),
+#endif /* CONFIG_AP */
+};
+
+
+static const struct wpas_ctrl_fast_cmd * wpas_ctrl_fast_cmd_get(const char *buf)
+{
+	const struct wpas_ctrl_fast_cmd *cmd;
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(wpas_ctrl_fast_cmds); i++) {
+		cmd = &wpas_ctrl_fast_cmds[i];
+		/* Cheap first character check before the full comparison */
+		if (cmd->verb[0] != buf[0])
+			continue;
+		if (cmd->prefix ? os_strncmp(buf, cmd->verb, cmd->len) == 0 :
+		    os_strcmp(buf, cmd->verb) == 0)
+			return cmd;
+	}
+
+	return NULL;
+}
+
+
 char * wpa_supplicant_ctrl_iface_process(struct wpa_supplicant *wpa_s,
 					 char *buf, size_t *resp_len)
 {
 	char *reply;
-	const int reply_size = 4096;
+	int reply_size = 4096;
 	int reply_len;
+	const struct wpas_ctrl_fast_cmd *cmd;
 
 	if (os_strncmp(buf, WPA_CTRL_RSP, os_strlen(WPA_CTRL_RSP)) == 0 ||
 	    os_strncmp(buf, "SET_NETWORK ", 12) == 0 ||
@@ -12824,6 +13017,11 @@ char * wpa_supplicant_ctrl_iface_process(struct wpa_supplicant *wpa_s,
 		wpa_dbg(wpa_s, level, "Control interface command '%s'", buf);
 	}
 
+	if (os_strcmp(buf, "BSS_DUMP") == 0 ||
+	    os_strncmp(buf, "BSS_DUMP ", 9) == 0 ||
+	    os_strncmp(buf, "LOG_RING", 8) == 0)
+		reply_size = WPA_CTRL_BULK_REPLY_SIZE;
+
 	reply = os_malloc(reply_size);
 	if (reply == NULL) {
 		*resp_len = 1;
@@ -12833,7 +13031,11 @@ char * wpa_supplicant_ctrl_iface_process(struct wpa_supplicant *wpa_s,
 	os_memcpy(reply, "OK\n", 3);
 	reply_len = 3;
 
-	if (os_strcmp(buf, "PING") == 0) {
+	cmd = wpas_ctrl_fast_cmd_get(buf);
+	if (cmd) {
+		reply_len = cmd->handler(wpa_s, buf + cmd->len, reply,
+					 reply_size);
+	} else if (os_strcmp(buf, "PING") == 0) {
 		os_memcpy(reply, "PONG\n", 5);
 		reply_len = 5;
 	} else if (os_strcmp(buf, "IFNAME") == 0) {
@@ -12856,9 +13058,6 @@ char * wpa_supplicant_ctrl_iface_process(struct wpa_supplicant *wpa_s,
 				reply_size - reply_len);
 #endif /* CONFIG_MACSEC */
 		}
-	} else if (os_strncmp(buf, "STATUS", 6) == 0) {
-		reply_len = wpa_supplicant_ctrl_iface_status(
-			wpa_s, buf + 6, reply, reply_size);
 	} else if (os_strcmp(buf, "PMKSA") == 0) {
 		reply_len = wpas_ctrl_iface_pmksa(wpa_s, reply, reply_size);
 	} else if (os_strcmp(buf, "PMKSA_FLUSH") == 0) {
@@ -13260,6 +13459,16 @@ char * wpa_supplicant_ctrl_iface_process(struct wpa_supplicant *wpa_s,
 	} else if (os_strncmp(buf, "LOG_LEVEL", 9) == 0) {
 		reply_len = wpa_supplicant_ctrl_iface_log_level(
 			wpa_s, buf + 9, reply, reply_size);
+#ifdef CONFIG_DEBUG_RING
+	} else if (os_strcmp(buf, "LOG_RING") == 0) {
+		reply_len = wpa_debug_ring_dump(reply, reply_size, 0);
+	} else if (os_strncmp(buf, "LOG_RING ", 9) == 0) {
+		reply_len = wpa_debug_ring_dump(reply, reply_size,
+						atoi(buf + 9));
+	} else if (os_strncmp(buf, "LOG_RING_LEVEL", 14) == 0) {
+		reply_len = wpa_supplicant_ctrl_iface_log_ring_level(
+			buf + 14, reply, reply_size);
+#endif /* CONFIG_DEBUG_RING */
 	} else if (os_strncmp(buf, "LIST_NETWORKS ", 14) == 0) {
 		reply_len = wpa_supplicant_ctrl_iface_list_networks(
 			wpa_s, buf + 14, reply, reply_size);
@@ -13272,9 +13481,6 @@ char * wpa_supplicant_ctrl_iface_process(struct wpa_supplicant *wpa_s,
 		wpas_ctrl_scan(wpa_s, NULL, reply, reply_size, &reply_len);
 	} else if (os_strncmp(buf, "SCAN ", 5) == 0) {
 		wpas_ctrl_scan(wpa_s, buf + 5, reply, reply_size, &reply_len);
-	} else if (os_strcmp(buf, "SCAN_RESULTS") == 0) {
-		reply_len = wpa_supplicant_ctrl_iface_scan_results(
-			wpa_s, reply, reply_size);
 	} else if (os_strcmp(buf, "ABORT_SCAN") == 0) {
 		if (wpas_abort_ongoing_scan(wpa_s) < 0)
 			reply_len = -1;
@@ -13339,18 +13545,7 @@ char * wpa_supplicant_ctrl_iface_process(struct wpa_supplicant *wpa_s,
 	} else if (os_strncmp(buf, "INTERFACES", 10) == 0) {
 		reply_len = wpa_supplicant_global_iface_interfaces(
 			wpa_s->global, buf + 10, reply, reply_size);
-	} else if (os_strncmp(buf, "BSS ", 4) == 0) {
-		reply_len = wpa_supplicant_ctrl_iface_bss(
-			wpa_s, buf + 4, reply, reply_size);
 #ifdef CONFIG_AP
-	} else if (os_strcmp(buf, "STA-FIRST") == 0) {
-		reply_len = ap_ctrl_iface_sta_first(wpa_s, reply, reply_size);
-	} else if (os_strncmp(buf, "STA ", 4) == 0) {
-		reply_len = ap_ctrl_iface_sta(wpa_s, buf + 4, reply,
-					      reply_size);
-	} else if (os_strncmp(buf, "STA-NEXT ", 9) == 0) {
-		reply_len = ap_ctrl_iface_sta_next(wpa_s, buf + 9, reply,
-						   reply_size);
 	} else if (os_strncmp(buf, "DEAUTHENTICATE ", 15) == 0) {
 		if (ap_ctrl_iface_sta_deauthenticate(wpa_s, buf + 15))
 			reply_len = -1;
@@ -13473,15 +13668,9 @@ char * wpa_supplicant_ctrl_iface_process(struct wpa_supplicant *wpa_s,
 		if (wmm_ac_ctrl_delts(wpa_s, buf + 13))
 			reply_len = -1;
 #endif /* CONFIG_NO_WMM_AC */
-	} else if (os_strncmp(buf, "SIGNAL_POLL", 11) == 0) {
-		reply_len = wpa_supplicant_signal_poll(wpa_s, reply,
-						       reply_size);
 	} else if (os_strncmp(buf, "SIGNAL_MONITOR", 14) == 0) {
 		if (wpas_ctrl_iface_signal_monitor(wpa_s, buf + 14))
 			reply_len = -1;
-	} else if (os_strncmp(buf, "PKTCNT_POLL", 11) == 0) {
-		reply_len = wpa_supplicant_pktcnt_poll(wpa_s, reply,
-						       reply_size);
 #ifdef CONFIG_AUTOSCAN
 	} else if (os_strncmp(buf, "AUTOSCAN ", 9) == 0) {
 		if (wpa_supplicant_ctrl_iface_autoscan(wpa_s, buf + 9))
@@ -101,9 +101,10 @@ static void wpas_ctrl_sock_debug(const char *title, int sock, const char *buf,
 
 static int wpa_supplicant_ctrl_iface_attach(struct dl_list *ctrl_dst,
 					    struct sockaddr_storage *from,
-					    socklen_t fromlen, int global)
+					    socklen_t fromlen, int global,
+					    const char *input)
 {
-	return ctrl_iface_attach(ctrl_dst, from, fromlen, NULL);
+	return ctrl_iface_attach(ctrl_dst, from, fromlen, input);
 }
 
 
@@ -157,9 +158,11 @@ static void wpa_supplicant_ctrl_iface_receive(int sock, void *eloop_ctx,
 	}
 	buf[res] = '\0';
 
-	if (os_strcmp(buf, "ATTACH") == 0) {
+	if (os_strcmp(buf, "ATTACH") == 0 ||
+	    os_strncmp(buf, "ATTACH ", 7) == 0) {
 		if (wpa_supplicant_ctrl_iface_attach(&priv->ctrl_dst, &from,
-						     fromlen, 0))
+						     fromlen, 0,
+						     buf[6] ? buf + 7 : NULL))
 			reply_len = 1;
 		else {
 			new_attached = 1;
@@ -425,6 +428,30 @@ static void wpas_ctrl_msg_queue_limit(unsigned int throttle_count,
 }
 
 
+static int wpa_supplicant_ctrl_iface_msg_wanted(void *ctx, int level,
+						 enum wpa_msg_type type)
+{
+	struct wpa_supplicant *wpa_s = ctx;
+	struct ctrl_iface_priv *priv;
+	struct ctrl_iface_global_priv *gpriv;
+
+	if (!wpa_s)
+		return 0;
+
+	gpriv = wpa_s->global->ctrl_iface;
+	if (type != WPA_MSG_NO_GLOBAL && gpriv &&
+	    ctrl_iface_monitor_wanted(&gpriv->ctrl_dst, level))
+		return 1;
+
+	priv = wpa_s->ctrl_iface;
+	if (type != WPA_MSG_ONLY_GLOBAL && priv &&
+	    ctrl_iface_monitor_wanted(&priv->ctrl_dst, level))
+		return 1;
+
+	return 0;
+}
+
+
 static void wpa_supplicant_ctrl_iface_msg_cb(void *ctx, int level,
 					     enum wpa_msg_type type,
 					     const char *txt, size_t len)
@@ -685,6 +712,7 @@ havesock:
 	eloop_register_read_sock(priv->sock, wpa_supplicant_ctrl_iface_receive,
 				 wpa_s, priv);
 	wpa_msg_register_cb(wpa_supplicant_ctrl_iface_msg_cb);
+	wpa_msg_register_wanted_cb(wpa_supplicant_ctrl_iface_msg_wanted);
 
 	os_free(buf);
 	return 0;
@@ -983,7 +1011,7 @@ static void wpa_supplicant_ctrl_iface_send(struct wpa_supplicant *wpa_s,
 		int _errno;
 		char txt[200];
 
-		if (level < dst->debug_level)
+		if (!ctrl_iface_event_wanted(dst, level, buf, len))
 			continue;
 
 		msg.msg_name = (void *) &dst->addr;
@@ -1063,7 +1091,7 @@ void wpa_supplicant_ctrl_iface_wait(struct ctrl_iface_priv *priv)
 			/* handle ATTACH signal of first monitor interface */
 			if (!wpa_supplicant_ctrl_iface_attach(&priv->ctrl_dst,
 							      &from, fromlen,
-							      0)) {
+							      0, NULL)) {
 				if (sendto(priv->sock, "OK\n", 3, 0,
 					   (struct sockaddr *) &from, fromlen) <
 				    0) {
@@ -1125,9 +1153,11 @@ static void wpa_supplicant_global_ctrl_iface_receive(int sock, void *eloop_ctx,
 	}
 	buf[res] = '\0';
 
-	if (os_strcmp(buf, "ATTACH") == 0) {
+	if (os_strcmp(buf, "ATTACH") == 0 ||
+	    os_strncmp(buf, "ATTACH ", 7) == 0) {
 		if (wpa_supplicant_ctrl_iface_attach(&priv->ctrl_dst, &from,
-						     fromlen, 1))
+						     fromlen, 1,
+						     buf[6] ? buf + 7 : NULL))
 			reply_len = 1;
 		else
 			reply_len = 2;
@@ -1375,6 +1405,7 @@ wpa_supplicant_global_ctrl_iface_init(struct wpa_global *global)
 	}
 
 	wpa_msg_register_cb(wpa_supplicant_ctrl_iface_msg_cb);
+	wpa_msg_register_wanted_cb(wpa_supplicant_ctrl_iface_msg_wanted);
 
 	return priv;
 }
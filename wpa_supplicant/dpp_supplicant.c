@@ -2876,7 +2876,7 @@ static void wpas_dpp_rx_peer_disc_resp(struct wpa_supplicant *wpa_s,
 		goto fail;
 	}
 
-	res = dpp_peer_intro(&intro, ssid->dpp_connector,
+	res = dpp_peer_intro(wpa_s->dpp, &intro, ssid->dpp_connector,
 			     ssid->dpp_netaccesskey,
 			     ssid->dpp_netaccesskey_len,
 			     ssid->dpp_csign,
@@ -4029,7 +4029,7 @@ wpas_dpp_rx_priv_peer_intro_notify(struct wpa_supplicant *wpa_s,
 		goto fail;
 	}
 
-	res = dpp_peer_intro(&intro, ssid->dpp_connector,
+	res = dpp_peer_intro(wpa_s->dpp, &intro, ssid->dpp_connector,
 			     ssid->dpp_netaccesskey,
 			     ssid->dpp_netaccesskey_len,
 			     ssid->dpp_csign,
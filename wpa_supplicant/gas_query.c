@@ -705,7 +705,7 @@ static void gas_query_start_cb(struct wpa_radio_work *work, int deinit)
 		if (wpas_update_random_addr_disassoc(wpa_s) < 0) {
 			wpa_msg(wpa_s, MSG_INFO,
 				"Failed to assign random MAC address for GAS");
-			gas_query_free(query, 1);
+			gas_query_done(gas, query, GAS_QUERY_INTERNAL_ERROR);
 			radio_work_done(work);
 			return;
 		}
@@ -912,3 +912,17 @@ int gas_query_stop(struct gas_query *gas, u8 dialog_token)
 
 	return -1;
 }
+
+
+/**
+ * gas_query_in_progress - Check whether a GAS query is still pending
+ * @gas: GAS query data from gas_query_init()
+ * @dst: Destination MAC address for the query
+ * @dialog_token: Dialog token returned by gas_query_req()
+ * Returns: 1 if the query is queued or in progress, 0 if it has been freed
+ */
+int gas_query_in_progress(struct gas_query *gas, const u8 *dst,
+			  u8 dialog_token)
+{
+	return !gas_query_dialog_token_available(gas, dst, dialog_token);
+}
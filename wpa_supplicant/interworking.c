@@ -121,6 +121,87 @@ static struct wpabuf * anqp_build_req(u16 info_ids[], size_t num_ids,
 }
 
 
+static void interworking_gas_slot_add(struct wpa_supplicant *wpa_s,
+				      struct wpa_bss *bss, u8 dialog_token)
+{
+	unsigned int i;
+
+	for (i = 0; i < INTERWORKING_MAX_ANQP_PENDING; i++) {
+		if (wpa_s->interworking_gas_used & BIT(i))
+			continue;
+		wpa_s->interworking_gas_bss[i] = bss;
+		os_memcpy(wpa_s->interworking_gas_addr[i], bss->bssid,
+			  ETH_ALEN);
+		wpa_s->interworking_gas_token[i] = dialog_token;
+		wpa_s->interworking_gas_used |= BIT(i);
+		wpa_s->interworking_anqp_pending++;
+		break;
+	}
+}
+
+
+static void interworking_gas_slot_release(struct wpa_supplicant *wpa_s,
+					  unsigned int i)
+{
+	wpa_s->interworking_gas_bss[i] = NULL;
+	wpa_s->interworking_gas_used &= ~BIT(i);
+	if (wpa_s->interworking_anqp_pending)
+		wpa_s->interworking_anqp_pending--;
+}
+
+
+static bool interworking_gas_slot_done(struct wpa_supplicant *wpa_s,
+				       const u8 *dst, u8 dialog_token)
+{
+	unsigned int i;
+
+	for (i = 0; i < INTERWORKING_MAX_ANQP_PENDING; i++) {
+		if (!(wpa_s->interworking_gas_used & BIT(i)) ||
+		    wpa_s->interworking_gas_token[i] != dialog_token ||
+		    !ether_addr_equal(wpa_s->interworking_gas_addr[i], dst))
+			continue;
+		interworking_gas_slot_release(wpa_s, i);
+		return true;
+	}
+
+	return false;
+}
+
+
+/*
+ * gas_query may free a queued query without calling the response callback,
+ * e.g., when the pending radio work is removed on FLUSH. Release the slots of
+ * such queries so that they do not block the fetch from completing.
+ */
+static void interworking_gas_slots_prune(struct wpa_supplicant *wpa_s)
+{
+	unsigned int i;
+
+	for (i = 0; i < INTERWORKING_MAX_ANQP_PENDING; i++) {
+		if (!(wpa_s->interworking_gas_used & BIT(i)) ||
+		    gas_query_in_progress(wpa_s->gas,
+					  wpa_s->interworking_gas_addr[i],
+					  wpa_s->interworking_gas_token[i]))
+			continue;
+		wpa_printf(MSG_DEBUG,
+			   "Interworking: ANQP query to " MACSTR
+			   " (dialog token %u) was dropped by gas_query",
+			   MAC2STR(wpa_s->interworking_gas_addr[i]),
+			   wpa_s->interworking_gas_token[i]);
+		interworking_gas_slot_release(wpa_s, i);
+	}
+}
+
+
+static void interworking_gas_slots_reset(struct wpa_supplicant *wpa_s)
+{
+	os_memset(wpa_s->interworking_gas_bss, 0,
+		  sizeof(wpa_s->interworking_gas_bss));
+	wpa_s->interworking_gas_used = 0;
+	wpa_s->interworking_anqp_pending = 0;
+}
+
+
 static void interworking_anqp_resp_cb(void *ctx, const u8 *dst,
 				      u8 dialog_token,
 				      enum gas_query_result result,
@@ -135,6 +216,11 @@ static void interworking_anqp_resp_cb(void *ctx, const u8 *dst,
 		   MAC2STR(dst), dialog_token, result, status_code);
 	anqp_resp_cb(wpa_s, dst, dialog_token, result, adv_proto, resp,
 		     status_code);
+
+	if (!interworking_gas_slot_done(wpa_s, dst, dialog_token))
+		wpa_printf(MSG_DEBUG,
+			   "ANQP: Response for a query from an earlier fetch");
+
 	interworking_next_anqp_fetch(wpa_s);
 }
 
@@ -257,7 +343,6 @@ static int interworking_anqp_send_req(struct wpa_supplicant *wpa_s,
 
 	wpa_msg(wpa_s, MSG_DEBUG, "Interworking: ANQP Query Request to " MACSTR,
 		MAC2STR(bss->bssid));
-	wpa_s->interworking_gas_bss = bss;
 
 	info_ids[num_info_ids++] = ANQP_CAPABILITY_LIST;
 	if (all) {
@@ -318,11 +403,12 @@ static int interworking_anqp_send_req(struct wpa_supplicant *wpa_s,
 		wpa_msg(wpa_s, MSG_DEBUG, "ANQP: Failed to send Query Request");
 		wpabuf_free(buf);
 		ret = -1;
-		eloop_register_timeout(0, 0, interworking_continue_anqp, wpa_s,
-				       NULL);
-	} else
+	} else {
 		wpa_msg(wpa_s, MSG_DEBUG,
 			"ANQP: Query started with dialog token %u", res);
+		interworking_gas_slot_add(wpa_s, bss, res);
+		wpa_s->interworking_anqp_freq = bss->freq;
+	}
 
 	return ret;
 }
@@ -567,36 +653,67 @@ static struct nai_realm * nai_realm_parse(struct wpabuf *anqp, u16 *count)
 
 static int nai_realm_match(struct nai_realm *realm, const char *home_realm)
 {
-	char *tmp, *pos, *end;
-	int match = 0;
+	const char *pos, *end;
+	size_t len;
 
 	if (realm->realm == NULL || home_realm == NULL)
 		return 0;
 
-	if (os_strchr(realm->realm, ';') == NULL)
-		return os_strcasecmp(realm->realm, home_realm) == 0;
-
-	tmp = os_strdup(realm->realm);
-	if (tmp == NULL)
-		return 0;
-
-	pos = tmp;
-	while (*pos) {
+	/* The Realm field may hold multiple realms separated with ';' */
+	len = os_strlen(home_realm);
+	pos = realm->realm;
+	for (;;) {
 		end = os_strchr(pos, ';');
-		if (end)
-			*end = '\0';
-		if (os_strcasecmp(pos, home_realm) == 0) {
-			match = 1;
-			break;
-		}
-		if (end == NULL)
+		if (!end)
+			end = pos + os_strlen(pos);
+		if ((size_t) (end - pos) == len &&
+		    os_strncasecmp(pos, home_realm, len) == 0)
+			return 1;
+		if (*end == '\0')
 			break;
 		pos = end + 1;
 	}
 
-	os_free(tmp);
+	return 0;
+}
+
 
-	return match;
+/**
+ * interworking_nai_realm_flush - Drop the parsed form of the NAI Realm list
+ * @anqp: ANQP data from a BSS entry
+ *
+ * This needs to be called whenever anqp->nai_realm is replaced or freed.
+ */
+void interworking_nai_realm_flush(struct wpa_bss_anqp *anqp)
+{
+	if (!anqp)
+		return;
+	nai_realm_free(anqp->nai_realm_parsed, anqp->nai_realm_count);
+	anqp->nai_realm_parsed = NULL;
+	anqp->nai_realm_count = 0;
+}
+
+
+static struct nai_realm * interworking_nai_realm_get(struct wpa_bss *bss,
+						     u16 *count)
+{
+	struct wpa_bss_anqp *anqp = bss->anqp;
+
+	if (!anqp || !anqp->nai_realm)
+		return NULL;
+
+	/* ANQP data may be shared between BSSs of the same ANQP domain, so the
+	 * parsed list is shared as well and only built once for all of them.
+	 */
+	if (!anqp->nai_realm_parsed) {
+		anqp->nai_realm_parsed = nai_realm_parse(anqp->nai_realm,
+							 &anqp->nai_realm_count);
+		if (!anqp->nai_realm_parsed)
+			return NULL;
+	}
+
+	*count = anqp->nai_realm_count;
+	return anqp->nai_realm_parsed;
 }
 
 
@@ -2129,9 +2246,7 @@ static struct wpa_cred * interworking_credentials_available_realm(
 	if (wpa_s->conf->cred == NULL)
 		return NULL;
 
-	wpa_msg(wpa_s, MSG_DEBUG, "Interworking: Parsing NAI Realm list from "
-		MACSTR, MAC2STR(bss->bssid));
-	realm = nai_realm_parse(bss->anqp->nai_realm, &count);
+	realm = interworking_nai_realm_get(bss, &count);
 	if (realm == NULL) {
 		wpa_msg(wpa_s, MSG_DEBUG,
 			"Interworking: Could not parse NAI Realm list from "
@@ -2181,8 +2296,6 @@ static struct wpa_cred * interworking_credentials_available_realm(
 		}
 	}
 
-	nai_realm_free(realm, count);
-
 	if (excluded)
 		*excluded = is_excluded;
 
@@ -2650,6 +2763,48 @@ static void interworking_select_network(struct wpa_supplicant *wpa_s)
 }
 
 
+static int interworking_anqp_domain_id(struct wpa_bss *bss)
+{
+	const u8 *ie, *pos, *end;
+	u8 conf;
+
+	ie = wpa_bss_get_vendor_ie(bss, HS20_IE_VENDOR_TYPE);
+	if (!ie || ie[1] < 5)
+		return -1;
+
+	pos = ie + 6;
+	end = ie + 2 + ie[1];
+	conf = *pos++;
+	if (conf & HS20_PPS_MO_ID_PRESENT)
+		pos += 2;
+	if (!(conf & HS20_ANQP_DOMAIN_ID_PRESENT) || end - pos < 2)
+		return -1;
+
+	return WPA_GET_LE16(pos);
+}
+
+
+static bool interworking_same_anqp_domain(struct wpa_bss *a,
+					  struct wpa_bss *b)
+{
+	int id_a, id_b;
+
+	if (is_zero_ether_addr(a->hessid))
+		return false; /* Cannot be in the same homegenous ESS */
+	if (!ether_addr_equal(a->hessid, b->hessid))
+		return false;
+	if (a->ssid_len != b->ssid_len ||
+	    os_memcmp(a->ssid, b->ssid, a->ssid_len) != 0)
+		return false;
+
+	/* Do not share ANQP data between BSSs that explicitly advertise
+	 * different ANQP Domain IDs */
+	id_a = interworking_anqp_domain_id(a);
+	id_b = interworking_anqp_domain_id(b);
+	return id_a < 0 || id_b < 0 || id_a == id_b;
+}
+
+
 static struct wpa_bss_anqp *
 interworking_match_anqp_info(struct wpa_supplicant *wpa_s, struct wpa_bss *bss)
 {
@@ -2670,10 +2825,7 @@ interworking_match_anqp_info(struct wpa_supplicant *wpa_s, struct wpa_bss *bss)
 			continue;
 		if (!(other->flags & WPA_BSS_ANQP_FETCH_TRIED))
 			continue;
-		if (!ether_addr_equal(bss->hessid, other->hessid))
-			continue;
-		if (bss->ssid_len != other->ssid_len ||
-		    os_memcmp(bss->ssid, other->ssid, bss->ssid_len) != 0)
+		if (!interworking_same_anqp_domain(bss, other))
 			continue;
 
 		wpa_msg(wpa_s, MSG_DEBUG,
@@ -2688,20 +2840,30 @@ interworking_match_anqp_info(struct wpa_supplicant *wpa_s, struct wpa_bss *bss)
 }
 
 
-static void interworking_next_anqp_fetch(struct wpa_supplicant *wpa_s)
+static bool interworking_anqp_wait_pending(struct wpa_supplicant *wpa_s,
+					   struct wpa_bss *bss)
 {
-	struct wpa_bss *bss;
-	int found = 0;
+	unsigned int i;
 
-	wpa_printf(MSG_DEBUG, "Interworking: next_anqp_fetch - "
-		   "fetch_anqp_in_progress=%d",
-		   wpa_s->fetch_anqp_in_progress);
+	for (i = 0; i < INTERWORKING_MAX_ANQP_PENDING; i++) {
+		struct wpa_bss *other = wpa_s->interworking_gas_bss[i];
 
-	if (eloop_terminated() || !wpa_s->fetch_anqp_in_progress) {
-		wpa_printf(MSG_DEBUG, "Interworking: Stop next-ANQP-fetch");
-		return;
+		if (!other)
+			continue;
+		if (ether_addr_equal(bss->bssid, other->bssid) ||
+		    interworking_same_anqp_domain(bss, other))
+			return true;
 	}
 
+	return false;
+}
+
+
+static struct wpa_bss *
+interworking_next_anqp_bss(struct wpa_supplicant *wpa_s)
+{
+	struct wpa_bss *bss, *first = NULL;
+
 	dl_list_for_each(bss, &wpa_s->bss, struct wpa_bss, list) {
 		if (!(bss->caps & IEEE80211_CAP_ESS))
 			continue;
@@ -2710,30 +2872,74 @@ static void interworking_next_anqp_fetch(struct wpa_supplicant *wpa_s)
 		if (disallowed_bssid(wpa_s, bss->bssid) ||
 		    disallowed_ssid(wpa_s, bss->ssid, bss->ssid_len))
 			continue; /* Disallowed BSS */
+		if (bss->flags & WPA_BSS_ANQP_FETCH_TRIED)
+			continue;
 
-		if (!(bss->flags & WPA_BSS_ANQP_FETCH_TRIED)) {
-			if (bss->anqp == NULL) {
-				bss->anqp = interworking_match_anqp_info(wpa_s,
-									 bss);
-				if (bss->anqp) {
-					/* Shared data already fetched */
-					continue;
-				}
-				bss->anqp = wpa_bss_anqp_alloc();
-				if (bss->anqp == NULL)
-					break;
+		/* Wait for a pending query to the same AP or to the same
+		 * ANQP domain to complete so that its results can be shared */
+		if (interworking_anqp_wait_pending(wpa_s, bss))
+			continue;
+
+		if (bss->anqp == NULL) {
+			bss->anqp = interworking_match_anqp_info(wpa_s, bss);
+			if (bss->anqp) {
+				/* Shared data already fetched */
+				bss->flags |= WPA_BSS_ANQP_FETCH_TRIED;
+				continue;
 			}
-			found++;
-			bss->flags |= WPA_BSS_ANQP_FETCH_TRIED;
-			wpa_msg(wpa_s, MSG_INFO, "Starting ANQP fetch for "
-				MACSTR " (HESSID " MACSTR ")",
-				MAC2STR(bss->bssid), MAC2STR(bss->hessid));
-			interworking_anqp_send_req(wpa_s, bss);
+		}
+
+		/* Prefer the channel of the previous query to reduce
+		 * off-channel switching */
+		if (bss->freq == wpa_s->interworking_anqp_freq)
+			return bss;
+		if (!first)
+			first = bss;
+	}
+
+	return first;
+}
+
+
+static void interworking_next_anqp_fetch(struct wpa_supplicant *wpa_s)
+{
+	struct wpa_bss *bss;
+
+	wpa_printf(MSG_DEBUG, "Interworking: next_anqp_fetch - "
+		   "fetch_anqp_in_progress=%d pending=%u",
+		   wpa_s->fetch_anqp_in_progress,
+		   wpa_s->interworking_anqp_pending);
+
+	if (eloop_terminated() || !wpa_s->fetch_anqp_in_progress) {
+		wpa_printf(MSG_DEBUG, "Interworking: Stop next-ANQP-fetch");
+		return;
+	}
+
+	interworking_gas_slots_prune(wpa_s);
+
+	/*
+	 * Keep up to INTERWORKING_MAX_ANQP_PENDING queries queued in
+	 * gas_query so that the next exchange can start as soon as the
+	 * previous one completes.
+	 */
+	while (wpa_s->interworking_anqp_pending <
+	       INTERWORKING_MAX_ANQP_PENDING) {
+		bss = interworking_next_anqp_bss(wpa_s);
+		if (!bss)
 			break;
+		if (bss->anqp == NULL) {
+			bss->anqp = wpa_bss_anqp_alloc();
+			if (bss->anqp == NULL)
+				break;
 		}
+		bss->flags |= WPA_BSS_ANQP_FETCH_TRIED;
+		wpa_msg(wpa_s, MSG_INFO, "Starting ANQP fetch for "
+			MACSTR " (HESSID " MACSTR ")",
+			MAC2STR(bss->bssid), MAC2STR(bss->hessid));
+		interworking_anqp_send_req(wpa_s, bss);
 	}
 
-	if (found == 0) {
+	if (wpa_s->interworking_anqp_pending == 0) {
 		wpa_msg(wpa_s, MSG_INFO, "ANQP fetch completed");
 		wpa_s->fetch_anqp_in_progress = 0;
 		if (wpa_s->network_select)
@@ -2750,6 +2956,8 @@ void interworking_start_fetch_anqp(struct wpa_supplicant *wpa_s)
 		bss->flags &= ~WPA_BSS_ANQP_FETCH_TRIED;
 
 	wpa_s->fetch_anqp_in_progress = 1;
+	wpa_s->interworking_anqp_freq = 0;
+	interworking_gas_slots_reset(wpa_s);
 
 	/*
 	 * Start actual ANQP operation from eloop call to make sure the loop
@@ -2779,6 +2987,7 @@ void interworking_stop_fetch_anqp(struct wpa_supplicant *wpa_s)
 		return;
 
 	wpa_s->fetch_anqp_in_progress = 0;
+	interworking_gas_slots_reset(wpa_s);
 }
 
 
@@ -2995,6 +3204,7 @@ static void interworking_parse_rx_anqp_resp(struct wpa_supplicant *wpa_s,
 			" NAI Realm list", MAC2STR(sa));
 		wpa_hexdump_ascii(MSG_DEBUG, "ANQP: NAI Realm", pos, slen);
 		if (anqp) {
+			interworking_nai_realm_flush(anqp);
 			wpabuf_free(anqp->nai_realm);
 			anqp->nai_realm = wpabuf_alloc_copy(pos, slen);
 		}
@@ -3108,6 +3318,7 @@ void anqp_resp_cb(void *ctx, const u8 *dst, u8 dialog_token,
 	u16 slen;
 	struct wpa_bss *bss = NULL, *tmp;
 	const char *anqp_result = "SUCCESS";
+	unsigned int i;
 
 	wpa_printf(MSG_DEBUG, "Interworking: anqp_resp_cb dst=" MACSTR
 		   " dialog_token=%u result=%d status_code=%u",
@@ -3131,9 +3342,9 @@ void anqp_resp_cb(void *ctx, const u8 *dst, u8 dialog_token,
 	 * for the request. This can help in cases where multiple BSS entries
 	 * may exist for the same AP.
 	 */
-	dl_list_for_each_reverse(tmp, &wpa_s->bss, struct wpa_bss, list) {
-		if (tmp == wpa_s->interworking_gas_bss &&
-		    ether_addr_equal(tmp->bssid, dst)) {
+	for (i = 0; i < INTERWORKING_MAX_ANQP_PENDING; i++) {
+		tmp = wpa_s->interworking_gas_bss[i];
+		if (tmp && ether_addr_equal(tmp->bssid, dst)) {
 			bss = tmp;
 			break;
 		}
@@ -3293,3 +3504,74 @@ int gas_send_request(struct wpa_supplicant *wpa_s, const u8 *dst,
 
 	return ret;
 }
+
+
+#ifdef CONFIG_MODULE_TESTS
+
+int interworking_module_tests(void)
+{
+	struct wpa_supplicant wpa_s;
+	struct wpa_global global;
+	struct wpa_bss *bss[INTERWORKING_MAX_ANQP_PENDING];
+	unsigned int i;
+	int ret = -1;
+
+	wpa_printf(MSG_INFO, "interworking module tests");
+
+	os_memset(&wpa_s, 0, sizeof(wpa_s));
+	os_memset(&global, 0, sizeof(global));
+	os_memset(bss, 0, sizeof(bss));
+	wpa_s.global = &global;
+	dl_list_init(&wpa_s.bss);
+	wpa_s.gas = gas_query_init(&wpa_s);
+	if (!wpa_s.gas)
+		goto fail;
+	for (i = 0; i < INTERWORKING_MAX_ANQP_PENDING; i++) {
+		bss[i] = os_zalloc(sizeof(*bss[i]));
+		if (!bss[i])
+			goto fail;
+		bss[i]->bssid[5] = i + 1;
+	}
+
+	/* Pipelined fetch stopped while all slots are in use */
+	wpa_s.fetch_anqp_in_progress = 1;
+	for (i = 0; i < INTERWORKING_MAX_ANQP_PENDING; i++)
+		interworking_gas_slot_add(&wpa_s, bss[i], i + 1);
+	if (wpa_s.interworking_anqp_pending != INTERWORKING_MAX_ANQP_PENDING)
+		goto fail;
+	interworking_stop_fetch_anqp(&wpa_s);
+	if (wpa_s.interworking_anqp_pending || wpa_s.interworking_gas_used)
+		goto fail;
+
+	/* A late response from the stopped fetch is not accounted to the
+	 * next one */
+	wpa_s.fetch_anqp_in_progress = 1;
+	for (i = 0; i < INTERWORKING_MAX_ANQP_PENDING; i++)
+		interworking_gas_slot_add(&wpa_s, bss[i], 10 + i);
+	if (interworking_gas_slot_done(&wpa_s, bss[0]->bssid, 1) ||
+	    wpa_s.interworking_anqp_pending != INTERWORKING_MAX_ANQP_PENDING ||
+	    !interworking_gas_slot_done(&wpa_s, bss[0]->bssid, 10) ||
+	    wpa_s.interworking_anqp_pending !=
+	    INTERWORKING_MAX_ANQP_PENDING - 1)
+		goto fail;
+
+	/* The queries were dropped by gas_query without a response callback
+	 * (e.g., FLUSH); the fetch must still complete */
+	interworking_next_anqp_fetch(&wpa_s);
+	if (wpa_s.fetch_anqp_in_progress ||
+	    wpa_s.interworking_anqp_pending || wpa_s.interworking_gas_used)
+		goto fail;
+
+	ret = 0;
+fail:
+	for (i = 0; i < INTERWORKING_MAX_ANQP_PENDING; i++)
+		os_free(bss[i]);
+	gas_query_deinit(wpa_s.gas);
+
+	if (ret)
+		wpa_printf(MSG_ERROR, "interworking module test failure");
+
+	return ret;
+}
+
+#endif /* CONFIG_MODULE_TESTS */
@@ -10,6 +10,7 @@
 #define INTERWORKING_H
 
 enum gas_query_result;
+struct wpa_bss_anqp;
 
 int anqp_send_req(struct wpa_supplicant *wpa_s, const u8 *dst, int freq,
 		  u16 info_ids[], size_t num_ids, u32 subtypes,
@@ -31,7 +32,9 @@ void interworking_start_fetch_anqp(struct wpa_supplicant *wpa_s);
 int interworking_home_sp_cred(struct wpa_supplicant *wpa_s,
 			      struct wpa_cred *cred,
 			      struct wpabuf *domain_names);
+void interworking_nai_realm_flush(struct wpa_bss_anqp *anqp);
 int domain_name_list_contains(struct wpabuf *domain_names,
 			      const char *domain, int exact_match);
+int interworking_module_tests(void);
 
 #endif /* INTERWORKING_H */
@@ -5956,7 +5956,7 @@ int wpas_p2p_init(struct wpa_global *global, struct wpa_supplicant *wpa_s)
 	p2p.concurrent_operations = !!(wpa_s->drv_flags &
 				       WPA_DRIVER_FLAGS_P2P_CONCURRENT);
 
-	p2p.max_peers = 100;
+	p2p.max_peers = wpa_s->conf->p2p_max_peers;
 
 	if (wpa_s->conf->p2p_ssid_postfix) {
 		p2p.ssid_postfix_len =
@@ -9557,6 +9557,9 @@ void wpas_p2p_update_config(struct wpa_supplicant *wpa_s)
 
 	if (wpa_s->conf->changed_parameters & CFG_CHANGED_P2P_PASSPHRASE_LEN)
 		p2p_set_passphrase_len(p2p, wpa_s->conf->p2p_passphrase_len);
+
+	if (wpa_s->conf->changed_parameters & CFG_CHANGED_P2P_MAX_PEERS)
+		p2p_set_max_peers(p2p, wpa_s->conf->p2p_max_peers);
 }
 
 
@@ -145,16 +145,63 @@ static int p2p_sd_dns_uncompress(char *buf, size_t buf_len, const u8 *msg,
 }
 
 
+/*
+ * Bonjour services are indexed by the uncompressed DNS name of the query key
+ * (or by the raw key if it cannot be uncompressed) together with the DNS Type
+ * and Version so that a request can be matched without having to uncompress
+ * the key of each registered service.
+ */
+static char * p2p_sd_bonjour_name(char *buf, size_t buf_len, const u8 *query,
+				  size_t query_len)
+{
+	if (query_len < 3 ||
+	    p2p_sd_dns_uncompress(buf, buf_len, query, query_len - 3, 0))
+		return NULL;
+	return buf;
+}
+
+
+static unsigned int p2p_sd_bonjour_hash(const char *name, const u8 *query,
+					size_t query_len)
+{
+	const u8 *pos, *end;
+	u32 hash = 5381;
+
+	if (name) {
+		pos = (const u8 *) name;
+		end = pos + os_strlen(name);
+	} else {
+		pos = query;
+		end = query + query_len;
+	}
+	while (pos < end)
+		hash = hash * 33 + *pos++;
+	if (name && query_len >= 3) {
+		/* DNS Type and Version */
+		for (pos = query + query_len - 3; pos < query + query_len;
+		     pos++)
+			hash = hash * 33 + *pos;
+	}
+
+	return hash % P2P_SRV_BONJOUR_HASH_SIZE;
+}
+
+
 static struct p2p_srv_bonjour *
 wpas_p2p_service_get_bonjour(struct wpa_supplicant *wpa_s,
 			     const struct wpabuf *query)
 {
 	struct p2p_srv_bonjour *bsrv;
 	size_t len;
+	unsigned int hash;
+	char name[256];
 
 	len = wpabuf_len(query);
-	dl_list_for_each(bsrv, &wpa_s->global->p2p_srv_bonjour,
-			 struct p2p_srv_bonjour, list) {
+	hash = p2p_sd_bonjour_hash(p2p_sd_bonjour_name(name, sizeof(name),
+						       wpabuf_head(query), len),
+				   wpabuf_head(query), len);
+	dl_list_for_each(bsrv, &wpa_s->global->p2p_srv_bonjour_hash[hash],
+			 struct p2p_srv_bonjour, hlist) {
 		if (len == wpabuf_len(bsrv->query) &&
 		    os_memcmp(wpabuf_head(query), wpabuf_head(bsrv->query),
 			      len) == 0)
@@ -259,10 +306,8 @@ static void wpas_sd_all_bonjour(struct wpa_supplicant *wpa_s,
 
 
 static int match_bonjour_query(struct p2p_srv_bonjour *bsrv, const u8 *query,
-			       size_t query_len)
+			       size_t query_len, const char *name)
 {
-	char str_rx[256], str_srv[256];
-
 	if (query_len < 3 || wpabuf_len(bsrv->query) < 3)
 		return 0; /* Too short to include DNS Type and Version */
 	if (os_memcmp(query + query_len - 3,
@@ -273,15 +318,8 @@ static int match_bonjour_query(struct p2p_srv_bonjour *bsrv, const u8 *query,
 	    os_memcmp(query, wpabuf_head(bsrv->query), query_len - 3) == 0)
 		return 1; /* Binary match */
 
-	if (p2p_sd_dns_uncompress(str_rx, sizeof(str_rx), query, query_len - 3,
-				  0))
-		return 0; /* Failed to uncompress query */
-	if (p2p_sd_dns_uncompress(str_srv, sizeof(str_srv),
-				  wpabuf_head(bsrv->query),
-				  wpabuf_len(bsrv->query) - 3, 0))
-		return 0; /* Failed to uncompress service */
-
-	return os_strcmp(str_rx, str_srv) == 0;
+	/* Compare uncompressed names if both could be uncompressed */
+	return name && bsrv->name && os_strcmp(name, bsrv->name) == 0;
 }
 
 
@@ -292,6 +330,8 @@ static void wpas_sd_req_bonjour(struct wpa_supplicant *wpa_s,
 	struct p2p_srv_bonjour *bsrv;
 	u8 *len_pos;
 	int matches = 0;
+	char str_rx[256], *name;
+	unsigned int hash;
 
 	wpa_hexdump_ascii(MSG_DEBUG, "P2P: SD Request for Bonjour",
 			  query, query_len);
@@ -307,9 +347,11 @@ static void wpas_sd_req_bonjour(struct wpa_supplicant *wpa_s,
 		return;
 	}
 
-	dl_list_for_each(bsrv, &wpa_s->global->p2p_srv_bonjour,
-			 struct p2p_srv_bonjour, list) {
-		if (!match_bonjour_query(bsrv, query, query_len))
+	name = p2p_sd_bonjour_name(str_rx, sizeof(str_rx), query, query_len);
+	hash = p2p_sd_bonjour_hash(name, query, query_len);
+	dl_list_for_each(bsrv, &wpa_s->global->p2p_srv_bonjour_hash[hash],
+			 struct p2p_srv_bonjour, hlist) {
+		if (!match_bonjour_query(bsrv, query, query_len, name))
 			continue;
 
 		if (wpabuf_tailroom(resp) <
@@ -1136,8 +1178,10 @@ void wpas_p2p_sd_service_update(struct wpa_supplicant *wpa_s)
 static void wpas_p2p_srv_bonjour_free(struct p2p_srv_bonjour *bsrv)
 {
 	dl_list_del(&bsrv->list);
+	dl_list_del(&bsrv->hlist);
 	wpabuf_free(bsrv->query);
 	wpabuf_free(bsrv->resp);
+	os_free(bsrv->name);
 	os_free(bsrv);
 }
 
@@ -1218,6 +1262,8 @@ int wpas_p2p_service_add_bonjour(struct wpa_supplicant *wpa_s,
 				 struct wpabuf *query, struct wpabuf *resp)
 {
 	struct p2p_srv_bonjour *bsrv;
+	char buf[256], *name;
+	unsigned int hash;
 
 	bsrv = os_zalloc(sizeof(*bsrv));
 	if (bsrv == NULL)
@@ -1228,11 +1274,23 @@ int wpas_p2p_service_add_bonjour(struct wpa_supplicant *wpa_s,
 	bsrv->resp = wpabuf_dup(resp);
 	if (!bsrv->resp)
 		goto error_query;
+	name = p2p_sd_bonjour_name(buf, sizeof(buf), wpabuf_head(query),
+				   wpabuf_len(query));
+	if (name) {
+		bsrv->name = os_strdup(name);
+		if (!bsrv->name)
+			goto error_resp;
+	}
+	hash = p2p_sd_bonjour_hash(name, wpabuf_head(query),
+				   wpabuf_len(query));
 	dl_list_add(&wpa_s->global->p2p_srv_bonjour, &bsrv->list);
+	dl_list_add(&wpa_s->global->p2p_srv_bonjour_hash[hash], &bsrv->hlist);
 
 	wpas_p2p_sd_service_update(wpa_s);
 	return 0;
 
+error_resp:
+	wpabuf_free(bsrv->resp);
 error_query:
 	wpabuf_free(bsrv->query);
 error_bsrv:
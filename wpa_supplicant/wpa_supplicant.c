@@ -8485,6 +8485,8 @@ struct wpa_global * wpa_supplicant_init(struct wpa_params *params)
 	if (global == NULL)
 		return NULL;
 	dl_list_init(&global->p2p_srv_bonjour);
+	for (i = 0; i < P2P_SRV_BONJOUR_HASH_SIZE; i++)
+		dl_list_init(&global->p2p_srv_bonjour_hash[i]);
 	dl_list_init(&global->p2p_srv_upnp);
 	global->params.daemonize = params->daemonize;
 	global->params.wait_for_monitor = params->wait_for_monitor;
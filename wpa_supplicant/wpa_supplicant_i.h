@@ -264,10 +264,14 @@ struct wpa_params {
 
 struct p2p_srv_bonjour {
 	struct dl_list list;
+	struct dl_list hlist; /* entry in wpa_global::p2p_srv_bonjour_hash */
 	struct wpabuf *query;
 	struct wpabuf *resp;
+	char *name; /* uncompressed DNS name from query or %NULL */
 };
 
+#define P2P_SRV_BONJOUR_HASH_SIZE 64
+
 struct p2p_srv_upnp {
 	struct dl_list list;
 	u8 version;
@@ -296,6 +300,7 @@ struct wpa_global {
 	u8 p2p_dev_addr[ETH_ALEN];
 	struct os_reltime p2p_go_wait_client;
 	struct dl_list p2p_srv_bonjour; /* struct p2p_srv_bonjour */
+	struct dl_list p2p_srv_bonjour_hash[P2P_SRV_BONJOUR_HASH_SIZE];
 	struct dl_list p2p_srv_upnp; /* struct p2p_srv_upnp */
 	int p2p_disabled;
 	int cross_connection;
@@ -1267,7 +1272,16 @@ struct wpa_supplicant {
 	unsigned int auto_network_select:1;
 	unsigned int interworking_fast_assoc_tried:1;
 	unsigned int fetch_all_anqp:1;
-	struct wpa_bss *interworking_gas_bss;
+#define INTERWORKING_MAX_ANQP_PENDING 4
+	/* BSSs with an ANQP fetch queued in gas_query */
+	struct wpa_bss *interworking_gas_bss[INTERWORKING_MAX_ANQP_PENDING];
+	/* Peer address and dialog token of each in-flight ANQP fetch; bit i
+	 * of interworking_gas_used is set while slot i is occupied */
+	u8 interworking_gas_addr[INTERWORKING_MAX_ANQP_PENDING][ETH_ALEN];
+	u8 interworking_gas_token[INTERWORKING_MAX_ANQP_PENDING];
+	unsigned int interworking_gas_used;
+	unsigned int interworking_anqp_pending;
+	int interworking_anqp_freq;
 #endif /* CONFIG_INTERWORKING */
 	unsigned int drv_capa_known;
 
@@ -12,6 +12,7 @@
 #include "utils/module_tests.h"
 #include "wpa_supplicant_i.h"
 #include "bssid_ignore.h"
+#include "interworking.h"
 
 
 static int wpas_bssid_ignore_module_tests(void)
@@ -99,6 +100,11 @@ int wpas_module_tests(void)
 	if (wpas_bssid_ignore_module_tests() < 0)
 		ret = -1;
 
+#ifdef CONFIG_INTERWORKING
+	if (interworking_module_tests() < 0)
+		ret = -1;
+#endif /* CONFIG_INTERWORKING */
+
 #ifdef CONFIG_WPS
 	if (wps_module_tests() < 0)
 		ret = -1;